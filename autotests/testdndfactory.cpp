@@ -10,12 +10,16 @@
 #include "testdndfactory.h"
 
 #include "dndfactory.h"
+#include "icaldrag.h"
 
 #include <KCalendarCore/MemoryCalendar>
 
+#include <QMimeData>
 #include <QTest>
 #include <QTimeZone>
 
+#include <memory>
+
 QTEST_MAIN(DndFactoryTest) // clipboard() needs GUI
 
 using namespace KCalendarCore;
@@ -131,4 +135,189 @@ void DndFactoryTest::testPasteTodo()
     QCOMPARE(todo->summary(), pastedTodo->summary());
 }
 
+void DndFactoryTest::testICalDragRoundTrip()
+{
+    const MemoryCalendar::Ptr calendar(new MemoryCalendar(QTimeZone::utc()));
+    const Event::Ptr event(new Event());
+    event->setSummary(QStringLiteral("Réunion – 会议"));
+    event->setDescription(QStringLiteral("Ünïcödé"));
+    event->setDtStart(QDateTime(QDate(2010, 8, 8), QTime(10, 0), QTimeZone::utc()));
+    event->setDtEnd(QDateTime(QDate(2010, 8, 8), QTime(11, 0), QTimeZone::utc()));
+    QVERIFY(calendar->addEvent(event));
+
+    QMimeData mimeData;
+    QVERIFY(ICalDrag::populateMimeData(&mimeData, calendar));
+
+    const MemoryCalendar::Ptr dropped(new MemoryCalendar(QTimeZone::utc()));
+    QVERIFY(ICalDrag::fromMimeData(&mimeData, dropped));
+
+    const Event::Ptr droppedEvent = dropped->event(event->uid());
+    QVERIFY(droppedEvent);
+    QCOMPARE(droppedEvent->summary(), event->summary());
+    QCOMPARE(droppedEvent->description(), event->description());
+    QCOMPARE(droppedEvent->dtStart(), event->dtStart());
+}
+
+void DndFactoryTest::testCreateMimeData()
+{
+    QVERIFY(!DndFactory::createMimeData({}));
+    QVERIFY(!DndFactory::createMimeData({Incidence::Ptr()}));
+
+    const Event::Ptr event(new Event());
+    event->setSummary(QStringLiteral("Summary"));
+    event->setDtStart(QDateTime(QDate(2010, 8, 8), QTime(10, 0), QTimeZone::utc()));
+    event->setDtEnd(QDateTime(QDate(2010, 8, 8), QTime(11, 0), QTimeZone::utc()));
+    const Todo::Ptr todo(new Todo());
+    todo->setSummary(QStringLiteral("To-do"));
+
+    const std::unique_ptr<QMimeData> mimeData(DndFactory::createMimeData({event, Incidence::Ptr(), todo}));
+    QVERIFY(mimeData);
+    QVERIFY(ICalDrag::canDecode(mimeData.get()));
+    QVERIFY(mimeData->formats().contains(ICalDrag::mimeType()));
+    QVERIFY(mimeData->hasHtml());
+    QVERIFY(mimeData->hasText());
+
+    // Later edits are not part of the copy
+    event->setSummary(QStringLiteral("Edited"));
+
+    const Calendar::Ptr calendar = DndFactory::createDropCalendar(mimeData.get());
+    QVERIFY(calendar);
+    QCOMPARE(calendar->incidences().size(), 2);
+    QCOMPARE(calendar->event(event->uid())->summary(), QStringLiteral("Summary"));
+    QCOMPARE(calendar->todo(todo->uid())->summary(), QStringLiteral("To-do"));
+
+    const QString text = mimeData->text();
+    QVERIFY(text.contains(QLatin1StringView("Summary")));
+    QVERIFY(text.contains(QLatin1StringView("To-do")));
+    QVERIFY(!mimeData->html().isEmpty());
+}
+
+void DndFactoryTest::testPasteTodoTree()
+{
+    const MemoryCalendar::Ptr calendar(new MemoryCalendar(QTimeZone::utc()));
+    const QDateTime due(QDate(2010, 8, 8), QTime(10, 0), QTimeZone::utc());
+
+    // A project of 100 tasks with 3 subtasks each, enough to paste concurrently
+    for (int i = 0; i < 100; ++i) {
+        const Todo::Ptr task(new Todo());
+        task->setUid(QStringLiteral("task-%1").arg(i));
+        task->setSummary(task->uid());
+        task->setDtDue(due);
+        QVERIFY(calendar->addTodo(task));
+        for (int j = 0; j < 3; ++j) {
+            const Todo::Ptr subtask(new Todo());
+            subtask->setUid(QStringLiteral("task-%1-%2").arg(i).arg(j));
+            subtask->setSummary(subtask->uid());
+            subtask->setDtDue(due);
+            subtask->setRelatedTo(task->uid());
+            QVERIFY(calendar->addTodo(subtask));
+        }
+    }
+
+    const Todo::Ptr unrelated(new Todo());
+    unrelated->setDtDue(due);
+    unrelated->setRelatedTo(QStringLiteral("not-in-the-calendar"));
+    QVERIFY(calendar->addTodo(unrelated));
+
+    const QDateTime newDue(QDate(2011, 1, 1), QTime(12, 0), QTimeZone::utc());
+    QStringList failedUids;
+    const Incidence::List pasted = DndFactory::pasteIncidences(calendar, newDue, {}, &failedUids);
+    QVERIFY(failedUids.isEmpty());
+    QCOMPARE(pasted.size(), 401);
+
+    QHash<QString, Incidence::Ptr> bySummary;
+    QHash<QString, Incidence::Ptr> byUid;
+    for (const Incidence::Ptr &incidence : pasted) {
+        QVERIFY(!calendar->incidence(incidence->uid()));
+        QCOMPARE(incidence.staticCast<Todo>()->dtDue(), newDue);
+        bySummary.insert(incidence->summary(), incidence);
+        byUid.insert(incidence->uid(), incidence);
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        const Incidence::Ptr task = bySummary.value(QStringLiteral("task-%1").arg(i));
+        QVERIFY(task);
+        QVERIFY(task->relatedTo().isEmpty());
+        for (int j = 0; j < 3; ++j) {
+            const Incidence::Ptr subtask = bySummary.value(QStringLiteral("task-%1-%2").arg(i).arg(j));
+            QVERIFY(subtask);
+            QCOMPARE(byUid.value(subtask->relatedTo()), task);
+        }
+    }
+    QVERIFY(bySummary.value(QString())->relatedTo().isEmpty());
+}
+
+void DndFactoryTest::testCreateDropIncidence()
+{
+    const QTimeZone berlin("Europe/Berlin");
+    const MemoryCalendar::Ptr calendar(new MemoryCalendar(QTimeZone::utc()));
+    for (int i = 0; i < 3; ++i) {
+        const Todo::Ptr todo(new Todo());
+        todo->setSummary(QStringLiteral("To-do %1").arg(i));
+        todo->setDtDue(QDateTime(QDate(2010, 8, 8 + i), QTime(10, 0), berlin));
+        Alarm::Ptr const alarm = todo->newAlarm();
+        alarm->setDisplayAlarm(QStringLiteral("Due"));
+        alarm->setEnabled(true);
+        QVERIFY(calendar->addTodo(todo));
+
+        const Event::Ptr event(new Event());
+        event->setSummary(QStringLiteral("Event %1").arg(i));
+        event->setDtStart(QDateTime(QDate(2010, 8, 8 + i), QTime(10, 0), berlin));
+        event->setDtEnd(QDateTime(QDate(2010, 8, 8 + i), QTime(11, 0), berlin));
+        QVERIFY(calendar->addEvent(event));
+    }
+
+    QMimeData mimeData;
+    QVERIFY(ICalDrag::populateMimeData(&mimeData, calendar));
+
+    const Event::Ptr event = DndFactory::createDropEvent(&mimeData);
+    QVERIFY(event);
+    const Event::Ptr original = calendar->event(event->uid());
+    QVERIFY(original);
+    QCOMPARE(event->summary(), original->summary());
+    QCOMPARE(event->dtStart(), original->dtStart());
+    QCOMPARE(event->dtStart().timeZone(), berlin);
+
+    const Todo::Ptr todo = DndFactory::createDropTodo(&mimeData);
+    QVERIFY(todo);
+    const Todo::Ptr originalTodo = calendar->todo(todo->uid());
+    QVERIFY(originalTodo);
+    QCOMPARE(todo->summary(), originalTodo->summary());
+    QCOMPARE(todo->dtDue(), originalTodo->dtDue());
+    QCOMPARE(todo->alarms().size(), 1);
+
+    // The whole calendar is still decoded on request
+    const Calendar::Ptr dropped = DndFactory::createDropCalendar(&mimeData);
+    QVERIFY(dropped);
+    QCOMPARE(dropped->incidences().size(), 6);
+
+    // Nothing to match
+    QMimeData journalData;
+    const MemoryCalendar::Ptr journals(new MemoryCalendar(QTimeZone::utc()));
+    QVERIFY(journals->addJournal(Journal::Ptr(new Journal())));
+    QVERIFY(ICalDrag::populateMimeData(&journalData, journals));
+    QVERIFY(!DndFactory::createDropEvent(&journalData));
+    QVERIFY(!DndFactory::createDropTodo(&journalData));
+}
+
+void DndFactoryTest::testCreateDropVCalendar()
+{
+    QMimeData mimeData;
+    mimeData.setData(ICalDrag::mimeType(),
+                     "BEGIN:VCALENDAR\r\n"
+                     "VERSION:1.0\r\n"
+                     "BEGIN:VEVENT\r\n"
+                     "UID:vcal-event\r\n"
+                     "SUMMARY:vCalendar event\r\n"
+                     "DTSTART:20100808T100000Z\r\n"
+                     "DTEND:20100808T110000Z\r\n"
+                     "END:VEVENT\r\n"
+                     "END:VCALENDAR\r\n");
+
+    const Event::Ptr event = DndFactory::createDropEvent(&mimeData);
+    QVERIFY(event);
+    QCOMPARE(event->summary(), QStringLiteral("vCalendar event"));
+    QCOMPARE(event->dtStart(), QDateTime(QDate(2010, 8, 8), QTime(10, 0), QTimeZone::utc()));
+}
+
 #include "moc_testdndfactory.cpp"
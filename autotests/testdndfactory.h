@@ -30,6 +30,30 @@ private Q_SLOTS:
      */
     void testPasteTodo();
 
+    /** Drags a non-ASCII event through ICalDrag, its text should survive the
+        UTF-8 payload unchanged.
+     */
+    void testICalDragRoundTrip();
+
+    /** Creates mime data for a selection, it should hold the incidences as
+        they were at that time, decode to a calendar and offer text and html.
+     */
+    void testCreateMimeData();
+
+    /** Pastes a large to-do tree, the pasted to-dos should form the same tree
+        with the new uids.
+     */
+    void testPasteTodoTree();
+
+    /** Drops a calendar with several incidences, only the first event or to-do
+        should be decoded, with its time zone.
+     */
+    void testCreateDropIncidence();
+
+    /** Drops vCalendar data that claims to be text/calendar.
+     */
+    void testCreateDropVCalendar();
+
     /** Things that need testing:
         - Paste to-do, changing dtStart instead of dtDue.
         - ...
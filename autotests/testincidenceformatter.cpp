@@ -9,26 +9,44 @@
 #include "testincidenceformatter.h"
 #include "test_config.h"
 
+#include "eventconflictindex_p.h"
+#include "formatterlabels_p.h"
 #include "grantleetemplatemanager_p.h"
+#include "htmltextutils_p.h"
 #include "incidenceformatter.h"
+#include "incidencelookupindex_p.h"
+#include "occurrencecache_p.h"
 
 #include <KCalendarCore/Event>
 #include <KCalendarCore/FreeBusy>
 #include <KCalendarCore/ICalFormat>
 #include <KCalendarCore/Journal>
 #include <KCalendarCore/MemoryCalendar>
+#include <KCalendarCore/ScheduleMessage>
 #include <KCalendarCore/Todo>
 
 #include <KLocalizedString>
 
+#include <QBitArray>
 #include <QDebug>
+#include <QDir>
+#include <QFuture>
 #include <QIcon>
 #include <QLocale>
+#include <QMutex>
 #include <QProcess>
 #include <QRegularExpression>
+#include <QSemaphore>
 #include <QStandardPaths>
 #include <QTest>
+#include <QTextDocumentFragment>
+#include <QThread>
+#include <QThreadPool>
 #include <QTimeZone>
+
+#include <functional>
+#include <memory>
+
 QTEST_MAIN(IncidenceFormatterTest)
 #ifndef Q_OS_WIN
 static void initLocale()
@@ -143,6 +161,34 @@ void IncidenceFormatterTest::testRecurrenceString()
     const QString hourStr2 = QLocale().toString(QTime(15, 0), QLocale::ShortFormat);
     QCOMPARE(IncidenceFormatter::recurrenceString(e3), i18n("Recurs every 2 hours until %1 (excluding %2,%3)", endDateStr, hourStr, hourStr2));
 
+    // TEST: A daily recurrence with many duplicated exclusions, only 7 distinct ones are listed //
+    const Event::Ptr e4 = Event::Ptr(new Event());
+    e4->setDtStart(kdt);
+    e4->setDtEnd(kdt.addSecs(60 * 60)); // 1hr event
+    Recurrence *r4 = e4->recurrence();
+    r4->setDaily(1);
+    QStringList exDates;
+    for (int i = 1; i <= 10; ++i) {
+        r4->addExDateTime(kdt.addDays(i));
+        r4->addExDate(kdt.addDays(i).date());
+        if (i <= 7) {
+            exDates << QLocale().toString(kdt.addDays(i).date(), QLocale::ShortFormat);
+        }
+    }
+    QCOMPARE(IncidenceFormatter::recurrenceString(e4),
+             i18n("%1 (excluding %2)", i18np("Recurs daily", "Recurs every %1 days", 1), exDates.join(u',') + i18nc("ellipsis", "...")));
+
+    // TEST: A weekly recurrence with both kinds of exclusions does not list an empty entry //
+    const Event::Ptr e5 = Event::Ptr(new Event());
+    e5->setDtStart(kdt);
+    e5->setDtEnd(kdt.addSecs(60 * 60)); // 1hr event
+    Recurrence *r5 = e5->recurrence();
+    r5->setWeekly(1, QBitArray(7, true));
+    r5->addExDateTime(kdt.addDays(7));
+    r5->addExDate(kdt.addDays(14).date());
+    QVERIFY(IncidenceFormatter::recurrenceString(e5).endsWith(
+        QStringLiteral("(excluding %1)").arg(QLocale().toString(kdt.addDays(7).date(), QLocale::ShortFormat))));
+
     //  qDebug() << "recurrenceString=" << IncidenceFormatter::recurrenceString( e3 );
 }
 
@@ -254,6 +300,64 @@ void IncidenceFormatterTest::cleanup(const QString &name)
     QFile::remove(QStringLiteral(TEST_DATA_DIR "/%1.out.html").arg(name));
 }
 
+void IncidenceFormatterTest::testRecurrenceStringLocaleChange()
+{
+    const Event::Ptr event(new Event);
+    event->setDtStart(QDateTime(QDate(2026, 1, 5), QTime(9, 0), QTimeZone::utc()));
+    event->setDtEnd(event->dtStart().addSecs(60 * 60));
+    event->recurrence()->setMonthly(1);
+    event->recurrence()->addMonthlyPos(2, 1); // 2nd Monday
+
+    const QString english = IncidenceFormatter::recurrenceString(event);
+    QVERIFY(english.contains(QLocale().dayName(1, QLocale::LongFormat)));
+
+    // The cached weekday names must follow a locale change
+    const QLocale defaultLocale;
+    const QLocale french(QStringLiteral("fr_FR"));
+    QLocale::setDefault(french);
+    const QString translated = IncidenceFormatter::recurrenceString(event);
+    QLocale::setDefault(defaultLocale);
+
+    QVERIFY(translated.contains(french.dayName(1, QLocale::LongFormat)));
+    QCOMPARE(IncidenceFormatter::recurrenceString(event), english);
+}
+
+void IncidenceFormatterTest::testRecurrenceStringCache()
+{
+    const Event::Ptr event(new Event);
+    event->setDtStart(QDateTime(QDate(2026, 1, 5), QTime(9, 0), QTimeZone::utc()));
+    event->setDtEnd(event->dtStart().addSecs(60 * 60));
+    event->setLastModified(QDateTime(QDate(2026, 1, 1), QTime(0, 0), QTimeZone::utc()));
+    event->recurrence()->setDaily(1);
+
+    const QString daily = IncidenceFormatter::recurrenceString(event);
+
+    IncidenceFormatter::setRecurrenceStringCacheEnabled(true);
+    QCOMPARE(IncidenceFormatter::recurrenceString(event), daily);
+
+    // Without a new revision or modification time the memoized string is returned
+    event->recurrence()->setDaily(2);
+    QCOMPARE(IncidenceFormatter::recurrenceString(event), daily);
+
+    event->setRevision(event->revision() + 1);
+    const QString everyOtherDay = IncidenceFormatter::recurrenceString(event);
+    QVERIFY(everyOtherDay != daily);
+
+    // A locale change invalidates the cached strings
+    event->recurrence()->setDaily(1);
+    const QLocale defaultLocale;
+    QLocale::setDefault(QLocale(QStringLiteral("fr_FR")));
+    QVERIFY(IncidenceFormatter::recurrenceString(event) != everyOtherDay);
+    QLocale::setDefault(defaultLocale);
+
+    IncidenceFormatter::clearRecurrenceStringCache();
+    QCOMPARE(IncidenceFormatter::recurrenceString(event), daily);
+
+    IncidenceFormatter::setRecurrenceStringCacheEnabled(false);
+    event->recurrence()->setDaily(2);
+    QCOMPARE(IncidenceFormatter::recurrenceString(event), everyOtherDay);
+}
+
 void IncidenceFormatterTest::testErrorTemplate()
 {
     const QString html = GrantleeTemplateManager::instance()->render(QStringLiteral("broken-template.html"), QVariantHash());
@@ -266,6 +370,187 @@ void IncidenceFormatterTest::testErrorTemplate()
     QCOMPARE(html, expected);
 }
 
+void IncidenceFormatterTest::testTemplateCache()
+{
+    GrantleeTemplateManager *manager = GrantleeTemplateManager::instance();
+    manager->clearTemplateCache();
+
+    const KCalendarCore::Calendar::Ptr calendar = loadCalendar(QStringLiteral("event-1"));
+    QVERIFY(calendar);
+    const auto events = calendar->events();
+    QCOMPARE(events.size(), 1);
+
+    const quint64 hits = manager->cacheHits();
+    const quint64 misses = manager->cacheMisses();
+
+    const QString html = IncidenceFormatter::extensiveDisplayStr(calendar, events[0]);
+    QCOMPARE(manager->cacheMisses(), misses + 1);
+    QCOMPARE(manager->cacheHits(), hits);
+
+    // The second rendering must reuse the compiled template and produce the same output
+    QCOMPARE(IncidenceFormatter::extensiveDisplayStr(calendar, events[0]), html);
+    QCOMPARE(manager->cacheMisses(), misses + 1);
+    QCOMPARE(manager->cacheHits(), hits + 1);
+
+    // Changing the plugin path invalidates the cache
+    manager->setPluginPath(QStringLiteral(TEST_PLUGIN_PATH));
+    QCOMPARE(IncidenceFormatter::extensiveDisplayStr(calendar, events[0]), html);
+    QCOMPARE(manager->cacheMisses(), misses + 2);
+
+    // Broken templates are never cached
+    const quint64 brokenMisses = manager->cacheMisses();
+    (void)manager->render(QStringLiteral("broken-template.html"), QVariantHash());
+    (void)manager->render(QStringLiteral("broken-template.html"), QVariantHash());
+    QCOMPARE(manager->cacheMisses(), brokenMisses + 2);
+}
+
+static QStringList formatCorpus(const std::function<KCalendarCore::Calendar::Ptr(const QString &)> &loadCalendar)
+{
+    static const QStringList displayNames = {QStringLiteral("event-1"),
+                                             QStringLiteral("event-2"),
+                                             QStringLiteral("event-exception-single"),
+                                             QStringLiteral("event-allday-multiday"),
+                                             QStringLiteral("todo-1"),
+                                             QStringLiteral("todo-2"),
+                                             QStringLiteral("journal-1")};
+    static const QStringList invitationNames = {QStringLiteral("itip-event"),
+                                                QStringLiteral("itip-event-request"),
+                                                QStringLiteral("itip-event-with-recurrence-attachment-reminder"),
+                                                QStringLiteral("itip-event-counterproposal"),
+                                                QStringLiteral("itip-todo-delegation-request"),
+                                                QStringLiteral("itip-journal-accepted-reply")};
+
+    QStringList results;
+    for (const QString &name : displayNames) {
+        const KCalendarCore::Calendar::Ptr calendar = loadCalendar(name);
+        if (!calendar) {
+            return {};
+        }
+        const auto incidences = calendar->incidences();
+        for (const auto &incidence : incidences) {
+            results.append(IncidenceFormatter::extensiveDisplayStr(calendar, incidence));
+            results.append(IncidenceFormatter::toolTipStr(QString(), incidence, QDate(), true));
+            results.append(IncidenceFormatter::recurrenceString(incidence));
+        }
+    }
+
+    for (const QString &name : invitationNames) {
+        QFile file(QStringLiteral(TEST_DATA_DIR "/%1.ical").arg(name));
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        const KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+        InvitationFormatterHelper helper;
+        results.append(IncidenceFormatter::formatICalInvitation(QString::fromUtf8(file.readAll()), calendar, &helper));
+    }
+    return results;
+}
+
+void IncidenceFormatterTest::testConcurrentFormatting()
+{
+    const auto load = [this](const QString &name) {
+        return loadCalendar(name);
+    };
+
+    // Single-threaded reference run
+    const QStringList reference = formatCorpus(load);
+    QVERIFY(!reference.isEmpty());
+
+    constexpr int threadCount = 8;
+    constexpr int iterations = 5;
+
+    QMutex mutex;
+    int mismatches = 0;
+    std::vector<std::unique_ptr<QThread>> threads;
+    threads.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(QThread::create([&]() {
+            for (int j = 0; j < iterations; ++j) {
+                if (formatCorpus(load) != reference) {
+                    const QMutexLocker locker(&mutex);
+                    ++mismatches;
+                }
+            }
+        }));
+        threads.back()->start();
+    }
+    for (const auto &thread : threads) {
+        QVERIFY(thread->wait());
+    }
+
+    QCOMPARE(mismatches, 0);
+}
+
+void IncidenceFormatterTest::testExtensiveDisplayStrs()
+{
+    const KCalendarCore::Calendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    for (const QString &name : {QStringLiteral("event-1"), QStringLiteral("event-2"), QStringLiteral("todo-1"), QStringLiteral("journal-1")}) {
+        const KCalendarCore::Calendar::Ptr source = loadCalendar(name);
+        QVERIFY(source);
+        const KCalendarCore::Incidence::List incidences = source->incidences();
+        for (const KCalendarCore::Incidence::Ptr &incidence : incidences) {
+            QVERIFY(calendar->addIncidence(incidence));
+        }
+    }
+
+    KCalendarCore::Incidence::List incidences;
+    for (int i = 0; i < 50; ++i) {
+        incidences += calendar->incidences();
+    }
+
+    QStringList expected;
+    for (const KCalendarCore::Incidence::Ptr &incidence : std::as_const(incidences)) {
+        expected.append(IncidenceFormatter::extensiveDisplayStr(calendar, incidence));
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    QCOMPARE(IncidenceFormatter::extensiveDisplayStrs(calendar, incidences, QDate(), &pool), expected);
+    QCOMPARE(IncidenceFormatter::extensiveDisplayStrs(calendar, incidences.mid(0, 1)), expected.mid(0, 1));
+    QVERIFY(IncidenceFormatter::extensiveDisplayStrs(calendar, {}).isEmpty());
+}
+
+void IncidenceFormatterTest::testExtensiveDisplaySection()
+{
+    const KCalendarCore::Calendar::Ptr calendar = loadCalendar(QStringLiteral("event-2"));
+    QVERIFY(calendar);
+    const auto events = calendar->events();
+    QCOMPARE(events.size(), 1);
+    const KCalendarCore::Event::Ptr event = events[0];
+
+    const QString section = IncidenceFormatter::extensiveDisplaySection(calendar, event, IncidenceFormatter::AttendeesSection);
+    QVERIFY(section.contains(QLatin1StringView("Volker Krause")));
+    QVERIFY(!section.contains(QLatin1StringView("Description:")));
+    QVERIFY(IncidenceFormatter::extensiveDisplayStr(calendar, event).contains(section));
+
+    event->addAttendee(KCalendarCore::Attendee(QStringLiteral("Jane Doe"), QStringLiteral("jane@example.com")));
+    const QString updated = IncidenceFormatter::extensiveDisplaySection(calendar, event, IncidenceFormatter::AttendeesSection);
+    QVERIFY(updated.contains(QLatin1StringView("Jane Doe")));
+    QVERIFY(IncidenceFormatter::extensiveDisplayStr(calendar, event).contains(updated));
+
+    const KCalendarCore::Journal::Ptr journal(new KCalendarCore::Journal);
+    QVERIFY(IncidenceFormatter::extensiveDisplaySection(calendar, journal, IncidenceFormatter::AttendeesSection).isEmpty());
+}
+
+void IncidenceFormatterTest::testFormatterLabels()
+{
+    const auto labels = FormatterLabels::get();
+    QVERIFY(labels);
+    QCOMPARE(labels->location, i18n("Location:"));
+    QCOMPARE(labels->summaryLinePattern.arg(QStringLiteral("Meeting")), i18n("Summary: %1\n", QStringLiteral("Meeting")));
+
+    // The table is shared as long as languages and locale stay the same
+    QCOMPARE(FormatterLabels::get(), labels);
+
+    // and rebuilt when one of them changes
+    const QLocale defaultLocale;
+    QLocale::setDefault(QLocale(QStringLiteral("de_DE")));
+    const auto germanLabels = FormatterLabels::get();
+    QLocale::setDefault(defaultLocale);
+    QVERIFY(germanLabels != labels);
+    QCOMPARE(labels->location, i18n("Location:"));
+}
+
 void IncidenceFormatterTest::testDisplayViewFormatEvent_data()
 {
     QTest::addColumn<QString>("name");
@@ -436,4 +721,461 @@ void IncidenceFormatterTest::testFormatIcalInvitation()
     cleanup(name);
 }
 
+namespace
+{
+class CalendarInvitationHelper : public InvitationFormatterHelper
+{
+public:
+    explicit CalendarInvitationHelper(const KCalendarCore::Calendar::Ptr &calendar)
+        : mCalendar(calendar)
+    {
+    }
+
+    [[nodiscard]] KCalendarCore::Calendar::Ptr calendar() const override
+    {
+        return mCalendar;
+    }
+
+private:
+    const KCalendarCore::Calendar::Ptr mCalendar;
+};
+
+class LinkInvitationHelper : public CalendarInvitationHelper
+{
+public:
+    using CalendarInvitationHelper::CalendarInvitationHelper;
+
+    [[nodiscard]] QString generateLinkURL(const QString &id) override
+    {
+        return QStringLiteral("link:") + id;
+    }
+};
+}
+
+void IncidenceFormatterTest::testFormatIcalInvitations()
+{
+    QStringList invitations;
+    const QStringList names = {QStringLiteral("itip-event"),
+                               QStringLiteral("itip-event-request"),
+                               QStringLiteral("itip-event-accepted-reply"),
+                               QStringLiteral("itip-todo"),
+                               QStringLiteral("itip-journal")};
+    for (const QString &name : names) {
+        QFile file(QStringLiteral(TEST_DATA_DIR "/%1.ical").arg(name));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        invitations.append(QString::fromUtf8(file.readAll()));
+    }
+
+    // Store a copy of the first invitation under a different UID, so that it can only
+    // be found through its scheduling ID
+    const KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    KCalendarCore::ICalFormat format;
+    const KCalendarCore::ScheduleMessage::Ptr msg = format.parseScheduleMessage(calendar, invitations.constFirst());
+    QVERIFY(msg);
+    const KCalendarCore::Incidence::Ptr existing(msg->event().staticCast<KCalendarCore::Incidence>()->clone());
+    existing->setSchedulingID(existing->uid(), KCalendarCore::CalFormat::createUniqueId());
+    QVERIFY(calendar->addIncidence(existing));
+
+    CalendarInvitationHelper helper(calendar);
+
+    QStringList expected;
+    for (const QString &invitation : std::as_const(invitations)) {
+        expected.append(IncidenceFormatter::formatICalInvitation(invitation, calendar, &helper));
+    }
+
+    QCOMPARE(IncidenceFormatter::formatICalInvitations(invitations, calendar, &helper), expected);
+    QCOMPARE(IncidenceFormatter::formatICalInvitations(invitations, calendar, &helper, true), expected);
+    QThreadPool pool;
+    pool.setMaxThreadCount(2);
+    QCOMPARE(IncidenceFormatter::formatICalInvitations(invitations, calendar, &helper, true, &pool), expected);
+    QVERIFY(IncidenceFormatter::formatICalInvitations({}, calendar, &helper).isEmpty());
+}
+
+void IncidenceFormatterTest::testFormatIcalInvitationAsync()
+{
+    QFile file(QStringLiteral(TEST_DATA_DIR "/itip-event-request.ical"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QString invitation = QString::fromUtf8(file.readAll());
+
+    const KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    CalendarInvitationHelper helper(calendar);
+
+    const QString sender = QStringLiteral("organizer@example.org");
+    const QString expected = IncidenceFormatter::formatICalInvitation(invitation, calendar, &helper);
+    const QString expectedNoHtml = IncidenceFormatter::formatICalInvitationNoHtml(invitation, calendar, &helper, sender);
+
+    QFuture<QString> future = IncidenceFormatter::formatICalInvitationAsync(invitation, calendar, &helper);
+    QCOMPARE(future.result(), expected);
+    future = IncidenceFormatter::formatICalInvitationAsync(invitation, calendar, &helper, true, sender);
+    QCOMPARE(future.result(), expectedNoHtml);
+
+    // A render canceled while queued never runs
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    QSemaphore release;
+    pool.start([&release]() {
+        release.acquire();
+    });
+    future = IncidenceFormatter::formatICalInvitationAsync(invitation, calendar, &helper, false, QString(), &pool);
+    future.cancel();
+    release.release();
+    future.waitForFinished();
+    QVERIFY(future.isCanceled());
+    QCOMPARE(future.resultCount(), 0);
+
+    // The helper may be deleted while the render is pending, its links are kept
+    QFile attachmentFile(QStringLiteral(TEST_DATA_DIR "/itip-event-with-recurrence-attachment-reminder.ical"));
+    QVERIFY(attachmentFile.open(QIODevice::ReadOnly));
+    const QString withAttachments = QString::fromUtf8(attachmentFile.readAll());
+    auto linkHelper = std::make_unique<LinkInvitationHelper>(calendar);
+    const QString expectedLinks = IncidenceFormatter::formatICalInvitation(withAttachments, calendar, linkHelper.get());
+    QVERIFY(expectedLinks.contains(QLatin1StringView("link:ATTACH:M0R0ZXN0ZmlsZS50eHQ=")));
+    pool.start([&release]() {
+        release.acquire();
+    });
+    future = IncidenceFormatter::formatICalInvitationAsync(withAttachments, calendar, linkHelper.get(), false, QString(), &pool);
+    linkHelper.reset();
+    release.release();
+    QCOMPARE(future.result(), expectedLinks);
+
+    // Labels are taken as the parser reads them, across folded lines and quoted parameters
+    const QString folded = QStringLiteral(
+        "BEGIN:VCALENDAR\r\n"
+        "PRODID:-//K Desktop Environment//NONSGML KCalUtils Test//EN\r\n"
+        "VERSION:2.0\r\n"
+        "METHOD:REQUEST\r\n"
+        "BEGIN:VEVENT\r\n"
+        "DTSTAMP:20260101T100000Z\r\n"
+        "ORGANIZER;CN=\"Organizer\":mailto:organizer@example.org\r\n"
+        "ATTENDEE;RSVP=TRUE;PARTSTAT=NEEDS-ACTION:mailto:attendee@example.org\r\n"
+        "UID:async-attachment-labels\r\n"
+        "SUMMARY:Attachments\r\n"
+        "DTSTART:20260301T100000Z\r\n"
+        "DTEND:20260301T110000Z\r\n"
+        "ATTACH;FMTTYPE=text/plain;ENCODING=BASE64;VALUE=BINARY;X-LABEL=\"Minutes; dr\r\n"
+        " aft, v2: ^'final^'.txt\":VGVzdAo=\r\n"
+        "ATTACH;FMTTYPE=application/pdf;X-LA\r\n"
+        "\tBEL=Agenda.pdf:https://example.org/agenda.pdf\r\n"
+        "END:VEVENT\r\n"
+        "END:VCALENDAR\r\n");
+    linkHelper = std::make_unique<LinkInvitationHelper>(calendar);
+    const QString expectedFolded = IncidenceFormatter::formatICalInvitation(folded, calendar, linkHelper.get());
+    QCOMPARE(expectedFolded.count(QLatin1StringView("link:ATTACH:")), 2);
+    QVERIFY(expectedFolded.contains(QLatin1StringView("link:ATTACH:") + QString::fromLatin1(QByteArrayLiteral("Agenda.pdf").toBase64())));
+    QVERIFY(!expectedFolded.contains(QLatin1StringView("link:ATTACH:\"")));
+    future = IncidenceFormatter::formatICalInvitationAsync(folded, calendar, linkHelper.get());
+    linkHelper.reset();
+    QCOMPARE(future.result(), expectedFolded);
+}
+
+void IncidenceFormatterTest::testFormatIcalInvitationModel_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<QString>("type");
+
+    QTest::newRow("event") << QStringLiteral("itip-event-request") << QStringLiteral("event");
+    QTest::newRow("todo") << QStringLiteral("itip-todo") << QStringLiteral("todo");
+    QTest::newRow("journal") << QStringLiteral("itip-journal") << QStringLiteral("journal");
+}
+
+void IncidenceFormatterTest::testFormatIcalInvitationModel()
+{
+    QFETCH(QString, name);
+    QFETCH(QString, type);
+
+    QFile file(QStringLiteral(TEST_DATA_DIR "/%1.ical").arg(name));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QString invitation = QString::fromUtf8(file.readAll());
+
+    const KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    InvitationFormatterHelper helper;
+
+    const QVariantHash model = IncidenceFormatter::formatICalInvitationModel(invitation, calendar, &helper);
+    QCOMPARE(model.value(QStringLiteral("type")).toString(), type);
+    QVERIFY(!model.value(QStringLiteral("summary")).toString().isEmpty());
+    QVERIFY(model.contains(QStringLiteral("buttons")));
+
+    // Rendering the model is what formatICalInvitation() does
+    QCOMPARE(IncidenceFormatter::renderICalInvitationModel(model), IncidenceFormatter::formatICalInvitation(invitation, calendar, &helper));
+
+    QVERIFY(IncidenceFormatter::formatICalInvitationModel(QString(), calendar, &helper).isEmpty());
+    QVERIFY(IncidenceFormatter::renderICalInvitationModel({}).isEmpty());
+
+    // The type must name one of the invitation templates
+    QVariantHash forged = model;
+    forged[QStringLiteral("type")] = QStringLiteral("../templates/itip");
+    QVERIFY(IncidenceFormatter::renderICalInvitationModel(forged).isEmpty());
+}
+
+void IncidenceFormatterTest::testIncidenceLookupIndex()
+{
+    KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+
+    const KCalendarCore::Event::Ptr event(new KCalendarCore::Event);
+    event->setDtStart(QDateTime(QDate(2026, 1, 1), QTime(10, 0), QTimeZone::utc()));
+    event->setSchedulingID(QStringLiteral("scheduling-1"));
+    QVERIFY(calendar->addIncidence(event));
+
+    IncidenceLookupIndex index(calendar);
+    QCOMPARE(index.size(), 1);
+    QCOMPARE(index.find(QStringLiteral("scheduling-1"), QDateTime()), KCalendarCore::Incidence::List{event});
+    QVERIFY(index.find(QStringLiteral("scheduling-1"), event->dtStart()).isEmpty());
+
+    // Additions, changes and removals are followed
+    const KCalendarCore::Event::Ptr exception(new KCalendarCore::Event);
+    exception->setDtStart(event->dtStart());
+    exception->setSchedulingID(QStringLiteral("scheduling-1"));
+    exception->setRecurrenceId(event->dtStart());
+    QVERIFY(calendar->addIncidence(exception));
+    QCOMPARE(index.find(QStringLiteral("scheduling-1"), event->dtStart()), KCalendarCore::Incidence::List{exception});
+
+    event->setSchedulingID(QStringLiteral("scheduling-2"));
+    QVERIFY(index.find(QStringLiteral("scheduling-1"), QDateTime()).isEmpty());
+    QCOMPARE(index.find(QStringLiteral("scheduling-2"), QDateTime()), KCalendarCore::Incidence::List{event});
+
+    // Copies sharing a key are all returned, in the order they were added
+    const KCalendarCore::Event::Ptr copy(new KCalendarCore::Event);
+    copy->setDtStart(event->dtStart());
+    copy->setSchedulingID(QStringLiteral("scheduling-2"));
+    QVERIFY(calendar->addIncidence(copy));
+    QCOMPARE(index.find(QStringLiteral("scheduling-2"), QDateTime()), (KCalendarCore::Incidence::List{event, copy}));
+    QVERIFY(calendar->deleteIncidence(copy));
+
+    QVERIFY(calendar->deleteIncidence(event));
+    QVERIFY(index.find(QStringLiteral("scheduling-2"), QDateTime()).isEmpty());
+    QCOMPARE(index.size(), 1);
+
+    // Attaching another calendar replaces the content
+    KCalendarCore::MemoryCalendar::Ptr other(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    index.attach(other);
+    QVERIFY(index.isAttachedTo(other));
+    QCOMPARE(index.size(), 0);
+
+    // The index must survive its calendar
+    other.clear();
+    index.attach(calendar);
+    QCOMPARE(index.size(), 1);
+    calendar.clear();
+    index.detach();
+    QCOMPARE(index.size(), 0);
+}
+
+void IncidenceFormatterTest::testEventConflictIndex()
+{
+    KCalendarCore::MemoryCalendar::Ptr calendar(new KCalendarCore::MemoryCalendar(QTimeZone::utc()));
+    const QDateTime day(QDate(2026, 3, 2), QTime(0, 0), QTimeZone::utc());
+    const QDateTime dayEnd(day.date(), QTime(23, 59, 59), QTimeZone::utc());
+
+    const auto makeEvent = [](const QDateTime &start, const QDateTime &end) {
+        const KCalendarCore::Event::Ptr event(new KCalendarCore::Event);
+        event->setDtStart(start);
+        event->setDtEnd(end);
+        return event;
+    };
+
+    const auto morning = makeEvent(day.addSecs(9 * 3600), day.addSecs(10 * 3600));
+    const auto evening = makeEvent(day.addSecs(20 * 3600), day.addSecs(21 * 3600));
+    const auto dayBefore = makeEvent(day.addDays(-1).addSecs(9 * 3600), day.addDays(-1).addSecs(10 * 3600));
+    // Starts long before the interval, but still runs during it
+    const auto conference = makeEvent(day.addDays(-3), day.addDays(1));
+    const auto weekly = makeEvent(day.addDays(-14).addSecs(12 * 3600), day.addDays(-14).addSecs(13 * 3600));
+    weekly->recurrence()->setWeekly(1);
+    const auto finished = makeEvent(day.addDays(-60), day.addDays(-60).addSecs(3600));
+    finished->recurrence()->setDaily(1);
+    finished->recurrence()->setDuration(5);
+    for (const auto &event : {morning, evening, dayBefore, conference, weekly, finished}) {
+        QVERIFY(calendar->addIncidence(event));
+    }
+
+    EventConflictIndex index(calendar);
+    QCOMPARE(index.size(), 6);
+    QCOMPARE(index.overlapping(day, dayEnd), KCalendarCore::Event::List({weekly, conference, morning, evening}));
+    QCOMPARE(index.overlapping(day.addSecs(11 * 3600), day.addSecs(19 * 3600)), KCalendarCore::Event::List({weekly, conference}));
+
+    // Spans are compared as absolute times, whatever the time zone of the event
+    const QTimeZone newYork("America/New_York");
+    const auto remote = makeEvent(QDateTime(day.date().addDays(-1), QTime(20, 0), newYork), QDateTime(day.date().addDays(-1), QTime(21, 0), newYork));
+    QVERIFY(calendar->addIncidence(remote));
+    QCOMPARE(index.overlapping(day, day.addSecs(3 * 3600)), KCalendarCore::Event::List({weekly, conference, remote}));
+    QVERIFY(!index.overlapping(day.addDays(-1), day.addSecs(-1)).contains(remote));
+    QVERIFY(calendar->deleteIncidence(remote));
+
+    // Events of very different lengths are found together
+    const auto season = makeEvent(day.addDays(-400), day.addDays(400));
+    QVERIFY(calendar->addIncidence(season));
+    QCOMPARE(index.overlapping(day.addSecs(11 * 3600), day.addSecs(19 * 3600)), KCalendarCore::Event::List({season, weekly, conference}));
+    QCOMPARE(index.overlapping(day.addDays(-2), day.addDays(-2).addSecs(3600)), KCalendarCore::Event::List({season, weekly, conference}));
+    QVERIFY(calendar->deleteIncidence(season));
+
+    // Additions, changes and removals are followed
+    const auto added = makeEvent(day.addSecs(15 * 3600), day.addSecs(16 * 3600));
+    QVERIFY(calendar->addIncidence(added));
+    QCOMPARE(index.overlapping(day.addSecs(11 * 3600), day.addSecs(19 * 3600)), KCalendarCore::Event::List({weekly, conference, added}));
+
+    conference->setDtEnd(day.addDays(-1));
+    QCOMPARE(index.overlapping(day, dayEnd), KCalendarCore::Event::List({weekly, morning, added, evening}));
+
+    QVERIFY(calendar->deleteIncidence(morning));
+    QCOMPARE(index.overlapping(day, dayEnd), KCalendarCore::Event::List({weekly, added, evening}));
+    QCOMPARE(index.size(), 6);
+
+    // The index must survive its calendar
+    calendar.clear();
+    index.detach();
+    QCOMPARE(index.size(), 0);
+}
+
+void IncidenceFormatterTest::testOccurrenceCache()
+{
+    OccurrenceCache::clear();
+
+    const KCalendarCore::Event::Ptr event(new KCalendarCore::Event);
+    const QDateTime start(QDate(2026, 3, 2), QTime(9, 0), QTimeZone::utc());
+    event->setDtStart(start);
+    event->setDtEnd(start.addSecs(3600));
+    event->recurrence()->setDaily(1);
+    event->recurrence()->setDuration(10);
+
+    const QDateTime from = start.addDays(2);
+    const QDateTime to = start.addDays(4).addSecs(1);
+    const QList<QDateTime> times = event->recurrence()->timesInInterval(from, to);
+    QCOMPARE(times.size(), 3);
+    QCOMPARE(OccurrenceCache::timesInInterval(event, from, to), times);
+    QCOMPARE(OccurrenceCache::size(), 1);
+    QCOMPARE(OccurrenceCache::timesInInterval(event, from, to), times);
+    QCOMPARE(OccurrenceCache::size(), 1);
+
+    QCOMPARE(OccurrenceCache::previousDateTime(event, from), start.addDays(1));
+    QCOMPARE(OccurrenceCache::nextDateTime(event, from), start.addDays(3));
+    QCOMPARE(OccurrenceCache::startDateTimesForDate(event, from.date(), QTimeZone::utc()), QList<QDateTime>{from});
+    QCOMPARE(OccurrenceCache::size(), 4);
+
+    // Editing the recurrence invalidates the cached results
+    event->recurrence()->addExDateTime(start.addDays(3));
+    QCOMPARE(OccurrenceCache::timesInInterval(event, from, to), event->recurrence()->timesInInterval(from, to));
+    QCOMPARE(OccurrenceCache::nextDateTime(event, from), start.addDays(4));
+
+    event->recurrence()->setDuration(3);
+    QCOMPARE(OccurrenceCache::timesInInterval(event, from, to), QList<QDateTime>{from});
+    QVERIFY(!OccurrenceCache::nextDateTime(event, from).isValid());
+
+    // Results are kept per incidence
+    const KCalendarCore::Event::Ptr other(event->clone());
+    other->recurrence()->setDuration(10);
+    QCOMPARE(OccurrenceCache::nextDateTime(other, from), start.addDays(4));
+
+    // Edits keeping the number of rules and dates are noticed as well
+    const KCalendarCore::Event::Ptr weekly(new KCalendarCore::Event);
+    weekly->setDtStart(start);
+    weekly->setDtEnd(start.addSecs(3600));
+    QBitArray days(7);
+    days.setBit(0);
+    weekly->recurrence()->setWeekly(1, days);
+    const QDateTime twoWeeks = start.addDays(13);
+    QCOMPARE(OccurrenceCache::timesInInterval(weekly, start, twoWeeks), (QList<QDateTime>{start, start.addDays(7)}));
+
+    // BYDAY
+    days.setBit(2);
+    weekly->recurrence()->addWeeklyDays(days);
+    QCOMPARE(OccurrenceCache::timesInInterval(weekly, start, twoWeeks),
+             (QList<QDateTime>{start, start.addDays(2), start.addDays(7), start.addDays(9)}));
+
+    // UNTIL
+    weekly->recurrence()->setEndDateTime(start.addDays(3));
+    QCOMPARE(OccurrenceCache::timesInInterval(weekly, start, twoWeeks), (QList<QDateTime>{start, start.addDays(2)}));
+
+    // EXDATE, replaced by another one
+    weekly->recurrence()->setExDateTimes({start});
+    QCOMPARE(OccurrenceCache::timesInInterval(weekly, start, twoWeeks), QList<QDateTime>{start.addDays(2)});
+    weekly->recurrence()->setExDateTimes({start.addDays(2)});
+    QCOMPARE(OccurrenceCache::timesInInterval(weekly, start, twoWeeks), QList<QDateTime>{start});
+
+    IncidenceFormatter::clearOccurrenceCache();
+    QCOMPARE(OccurrenceCache::size(), 0);
+}
+
+void IncidenceFormatterTest::testHtmlToPlainText_data()
+{
+    QTest::addColumn<QString>("html");
+
+    QTest::newRow("plain") << QStringLiteral("whatever");
+    QTest::newRow("paragraph") << QStringLiteral("<p>whatever</p>");
+    QTest::newRow("paragraphs") << QStringLiteral("<p>a</p><p>b</p>");
+    QTest::newRow("nested blocks") << QStringLiteral("<div><p>a</p></div><ul><li>b</li><li>c</li></ul>");
+    QTest::newRow("line break") << QStringLiteral("a<br>b<br/>c");
+    QTest::newRow("whitespace") << QStringLiteral("  a \n\t b");
+    QTest::newRow("newline") << QStringLiteral("a\nb");
+    QTest::newRow("inline tags") << QStringLiteral("<b>bold</b> and <i>italic</i> and <a href=\"x>y\">link</a>");
+    QTest::newRow("entities") << QStringLiteral("a &amp; b &lt;tag&gt; &quot;q&quot; &eacute;&euro;&#233;&#xE9;");
+    QTest::newRow("nbsp") << QStringLiteral("x&nbsp;y&nbsp;&nbsp;z");
+    QTest::newRow("unknown entity") << QStringLiteral("a &bogus; b & c");
+    QTest::newRow("style") << QStringLiteral("<style>p { color: red; }</style>text");
+    QTest::newRow("document") << QStringLiteral(
+        "<!DOCTYPE html><html><head><title>t</title></head><body><!-- comment --><h1>Title</h1><p>Body</p></body></html>");
+    QTest::newRow("pre") << QStringLiteral("<pre>a  b\n c</pre>");
+}
+
+void IncidenceFormatterTest::testHtmlToPlainText()
+{
+    QFETCH(const QString, html);
+
+    QCOMPARE(htmlToPlainText(html), QTextDocumentFragment::fromHtml(html).toPlainText());
+}
+
+void IncidenceFormatterTest::testHtmlToPlainTextCorpus()
+{
+    const QStringList files = QDir(QStringLiteral(TEST_DATA_DIR)).entryList({QStringLiteral("*.ical")}, QDir::Files);
+    QVERIFY(!files.isEmpty());
+
+    KCalendarCore::ICalFormat format;
+    for (const QString &file : files) {
+        const auto calendar = KCalendarCore::MemoryCalendar::Ptr::create(QTimeZone::utc());
+        if (!format.load(calendar, QStringLiteral(TEST_DATA_DIR "/") + file)) {
+            continue;
+        }
+        const auto incidences = calendar->incidences();
+        for (const KCalendarCore::Incidence::Ptr &incidence : incidences) {
+            for (const QString &html : {incidence->summary(), incidence->description(), incidence->location()}) {
+                QCOMPARE(htmlToPlainText(html), QTextDocumentFragment::fromHtml(html).toPlainText());
+            }
+        }
+    }
+}
+
+void IncidenceFormatterTest::testTruncateRichText_data()
+{
+    QTest::addColumn<QString>("html");
+    QTest::addColumn<int>("maxLength");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("short") << QStringLiteral("<p>short</p>") << 10 << QStringLiteral("<p>short</p>");
+    QTest::newRow("exact") << QStringLiteral("<p>0123456789</p>") << 10 << QStringLiteral("<p>0123456789</p>");
+    QTest::newRow("paragraph") << QStringLiteral("<p>0123456789abc</p>") << 10 << QStringLiteral("<p>0123456789...</p>");
+    QTest::newRow("nested") << QStringLiteral("<div><b>01234</b><i>56789abc</i></div>") << 10 << QStringLiteral("<div><b>01234</b><i>56789...</i></div>");
+    QTest::newRow("closed") << QStringLiteral("<b>0123456789</b>abc") << 10 << QStringLiteral("<b>0123456789</b>...");
+    QTest::newRow("void elements") << QStringLiteral("<p>01234<br>56789<img src=\"x\">abc</p>") << 10
+                                   << QStringLiteral("<p>01234<br>56789<img src=\"x\">...</p>");
+    QTest::newRow("implicitly closed") << QStringLiteral("<ul><li><b>01234<li>56789abc</ul>") << 10
+                                       << QStringLiteral("<ul><li><b>01234<li>56789...</li></ul>");
+    QTest::newRow("implicitly closed paragraph") << QStringLiteral("<div><p>01234<p>56789abc</div>") << 10
+                                                 << QStringLiteral("<div><p>01234<p>56789...</p></div>");
+    QTest::newRow("implicitly closed cells") << QStringLiteral("<table><tr><td>01234<td>5678<tr><td>9abc</table>") << 10
+                                             << QStringLiteral("<table><tr><td>01234<td>5678<tr><td>9...</td></tr></table>");
+    QTest::newRow("nested lists") << QStringLiteral("<ul><li>01<ul><li>234<li>56</ul><li>789abc</ul>") << 10
+                                  << QStringLiteral("<ul><li>01<ul><li>234<li>56</ul><li>789...</li></ul>");
+    QTest::newRow("entities") << QStringLiteral("&lt;&amp;&gt;3456789abc") << 10 << QStringLiteral("&lt;&amp;&gt;3456789...");
+    QTest::newRow("whitespace") << QStringLiteral("<p>  01234 \n   6789abc</p>") << 10 << QStringLiteral("<p>  01234 \n   6789...</p>");
+    QTest::newRow("style") << QStringLiteral("<style>p { color: red; }</style><p>0123456789abc</p>") << 10
+                           << QStringLiteral("<style>p { color: red; }</style><p>0123456789...</p>");
+}
+
+void IncidenceFormatterTest::testTruncateRichText()
+{
+    QFETCH(const QString, html);
+    QFETCH(const int, maxLength);
+    QFETCH(const QString, expected);
+
+    QCOMPARE(truncateRichText(html, maxLength, u"..."), expected);
+}
+
 #include "moc_testincidenceformatter.cpp"
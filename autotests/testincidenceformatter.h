@@ -28,8 +28,22 @@ private Q_SLOTS:
 
     void testRecurrenceString();
 
+    void testRecurrenceStringLocaleChange();
+
+    void testRecurrenceStringCache();
+
     void testErrorTemplate();
 
+    void testTemplateCache();
+
+    void testConcurrentFormatting();
+
+    void testFormatterLabels();
+
+    void testExtensiveDisplayStrs();
+
+    void testExtensiveDisplaySection();
+
     void testDisplayViewFormatEvent_data();
     void testDisplayViewFormatEvent();
 
@@ -44,4 +58,25 @@ private Q_SLOTS:
 
     void testFormatIcalInvitation_data();
     void testFormatIcalInvitation();
+
+    void testFormatIcalInvitations();
+
+    void testFormatIcalInvitationAsync();
+
+    void testFormatIcalInvitationModel_data();
+    void testFormatIcalInvitationModel();
+
+    void testIncidenceLookupIndex();
+
+    void testEventConflictIndex();
+
+    void testOccurrenceCache();
+
+    void testHtmlToPlainText_data();
+    void testHtmlToPlainText();
+
+    void testHtmlToPlainTextCorpus();
+
+    void testTruncateRichText_data();
+    void testTruncateRichText();
 };
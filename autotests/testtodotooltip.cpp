@@ -387,6 +387,28 @@ void TestTodoToolTip::testPriority()
     QVERIFY(toolTip.contains(field(PRIORITY, QStringLiteral("5"))));
 }
 
+// Plain text tool tips carry the same fields as rich text ones, without any markup.
+void TestTodoToolTip::testPlainText()
+{
+    auto todo = makeToDo(!ALL_DAY, RECURS, START_DT, DUE_DT);
+    todo->setPriority(5);
+    todo->setDescription(QStringLiteral("<p>Bring <b>coffee</b></p>"));
+
+    const auto richToolTip = toolTipStr(CAL_NAME, todo, AS_OF_DATE, true);
+    QVERIFY(richToolTip.startsWith(QLatin1StringView("<qt>")));
+
+    const auto toolTip = toolTipStr(CAL_NAME, todo, AS_OF_DATE, false);
+    QVERIFY(!toolTip.contains(u'<'));
+    QVERIFY(!toolTip.contains(QLatin1StringView("&nbsp;")));
+    QVERIFY(toolTip.startsWith(SUMMARY + u'\n'));
+    QVERIFY(toolTip.contains(field(CALENDAR, CAL_NAME))); // NOLINT(readability-suspicious-call-argument)
+    QVERIFY(toolTip.contains(field(START)));
+    QVERIFY(toolTip.contains(field(DUE)));
+    QVERIFY(toolTip.contains(field(PRIORITY, QStringLiteral("5"))));
+    QVERIFY(toolTip.contains(field(RECURRENCE, EXPECTED_RECURRENCE)));
+    QVERIFY(toolTip.contains(QLatin1StringView("Bring coffee")));
+}
+
 QTEST_GUILESS_MAIN(TestTodoToolTip)
 
 #include "moc_testtodotooltip.cpp"
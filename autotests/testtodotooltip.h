@@ -25,4 +25,5 @@ private Q_SLOTS:
     void testAlldayRecurringDone();
     void testTimedRecurringDone();
     void testPriority();
+    void testPlainText();
 };
@@ -0,0 +1,480 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "benchmarkformatter.h"
+#include "benchmark_config.h"
+
+#include "dndfactory.h"
+#include "icaldrag.h"
+#include "incidenceformatter.h"
+
+#include <KCalendarCore/Event>
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+#include <KCalendarCore/Todo>
+
+#include <QFile>
+#include <QMimeData>
+#include <QTest>
+#include <QTimeZone>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Count every heap allocation of the process, so that the benchmarks can
+// report allocations per formatted string.
+static std::atomic<quint64> sAllocations{0};
+
+void *operator new(std::size_t size)
+{
+    ++sAllocations;
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+QTEST_MAIN(BenchmarkFormatter)
+
+#ifndef Q_OS_WIN
+static void initLocale()
+{
+    setenv("LC_ALL", "en_US.utf-8", 1);
+    setenv("TZ", "UTC", 1);
+}
+
+Q_CONSTRUCTOR_FUNCTION(initLocale)
+#endif
+
+using namespace KCalendarCore;
+using namespace KCalUtils;
+
+// An event with a long description, reminders, tags and a full attendee list
+static Incidence::Ptr makeBusyEvent()
+{
+    const Event::Ptr event(new Event);
+    event->setSummary(QStringLiteral("Quarterly planning"));
+    event->setLocation(QStringLiteral("Meeting room 4"));
+    event->setDescription(QStringLiteral("Agenda: review of the last quarter, planning of the next one. ").repeated(4));
+    event->setDtStart(QDateTime(QDate(2026, 3, 2), QTime(9, 0), QTimeZone::utc()));
+    event->setDtEnd(QDateTime(QDate(2026, 3, 2), QTime(11, 30), QTimeZone::utc()));
+    event->recurrence()->setWeekly(1);
+    event->setCategories({QStringLiteral("Work"), QStringLiteral("Planning")});
+    event->setOrganizer(Person(QStringLiteral("Organizer"), QStringLiteral("organizer@example.org")));
+
+    const Attendee::Role roles[] = {Attendee::Chair, Attendee::ReqParticipant, Attendee::OptParticipant, Attendee::NonParticipant};
+    for (int i = 0; i < 20; ++i) {
+        event->addAttendee(Attendee(QStringLiteral("Attendee %1").arg(i),
+                                    QStringLiteral("attendee%1@example.org").arg(i),
+                                    true,
+                                    Attendee::NeedsAction,
+                                    roles[i % 4]));
+    }
+
+    const Alarm::Ptr alarm = event->newAlarm();
+    alarm->setStartOffset(Duration(-15 * 60));
+    alarm->setEnabled(true);
+    return event;
+}
+
+// Number of events of the synthetic calendar
+static constexpr int sLargeCalendarSize = 2000;
+
+static const QString sLargeCalendarName = QStringLiteral("synthetic-large");
+
+// The calendars of the test corpus every benchmark runs on
+static const QStringList sCorpus = {
+    QStringLiteral("event-1"),
+    QStringLiteral("event-2"),
+    QStringLiteral("event-allday"),
+    QStringLiteral("event-allday-multiday"),
+    QStringLiteral("event-exception-single"),
+    QStringLiteral("event-exception-thisandfuture"),
+    QStringLiteral("event-multiday"),
+    QStringLiteral("todo-1"),
+    QStringLiteral("todo-2"),
+    QStringLiteral("journal-1"),
+};
+
+// The invitations of the test corpus, covering requests, replies and counter proposals
+static const QStringList sInvitationCorpus = {
+    QStringLiteral("itip-event"),
+    QStringLiteral("itip-event-request"),
+    QStringLiteral("itip-event-accepted-reply"),
+    QStringLiteral("itip-event-counterproposal"),
+    QStringLiteral("itip-event-delegation-request"),
+    QStringLiteral("itip-event-with-recurrence-attachment-reminder"),
+    QStringLiteral("itip-journal-accepted-reply"),
+};
+
+// A calendar mixing plain, all-day, recurring and busy events, all with reminders
+static Calendar::Ptr makeLargeCalendar()
+{
+    auto calendar = MemoryCalendar::Ptr::create(QTimeZone::utc());
+    const QDateTime start(QDate(2026, 1, 5), QTime(8, 0), QTimeZone::utc());
+    for (int i = 0; i < sLargeCalendarSize; ++i) {
+        Event::Ptr event;
+        if (i % 10 == 0) {
+            event = makeBusyEvent().staticCast<Event>();
+        } else {
+            event = Event::Ptr(new Event);
+            event->setSummary(QStringLiteral("Event %1").arg(i));
+            event->setLocation(QStringLiteral("Room %1").arg(i % 7));
+            event->setDtStart(start.addSecs(i * 45 * 60));
+            event->setDtEnd(start.addSecs(i * 45 * 60 + 30 * 60));
+            event->setAllDay(i % 10 == 5);
+            if (i % 3 == 0) {
+                event->recurrence()->setDaily(1);
+                event->recurrence()->setDuration(10);
+                event->recurrence()->addExDateTime(event->dtStart().addDays(2));
+            }
+            const Alarm::Ptr alarm = event->newAlarm();
+            alarm->setStartOffset(Duration(-5 * 60));
+            alarm->setEnabled(true);
+        }
+        calendar->addEvent(event);
+    }
+    return calendar;
+}
+
+Calendar::Ptr BenchmarkFormatter::calendar(const QString &name)
+{
+    auto it = mCalendars.constFind(name);
+    if (it != mCalendars.constEnd()) {
+        return it.value();
+    }
+
+    Calendar::Ptr calendar;
+    if (name == sLargeCalendarName) {
+        calendar = makeLargeCalendar();
+    } else {
+        calendar = MemoryCalendar::Ptr::create(QTimeZone::utc());
+        ICalFormat format;
+        if (!format.load(calendar, QStringLiteral(BENCHMARK_DATA_DIR "/%1.ical").arg(name))) {
+            return {};
+        }
+    }
+    mCalendars.insert(name, calendar);
+    return calendar;
+}
+
+void BenchmarkFormatter::addCalendarRows()
+{
+    QTest::addColumn<QString>("name");
+
+    for (const QString &name : sCorpus) {
+        QTest::newRow(qPrintable(name)) << name;
+    }
+    QTest::newRow(qPrintable(sLargeCalendarName)) << sLargeCalendarName;
+}
+
+static void addToolTipRows()
+{
+    QTest::addColumn<Incidence::Ptr>("incidence");
+
+    for (const QString &name : {QStringLiteral("event-1"), QStringLiteral("event-multiday"), QStringLiteral("todo-1")}) {
+        auto calendar = MemoryCalendar::Ptr::create(QTimeZone::utc());
+        ICalFormat format;
+        QVERIFY(format.load(calendar, QStringLiteral(BENCHMARK_DATA_DIR "/%1.ical").arg(name)));
+        const Incidence::List incidences = calendar->incidences();
+        QVERIFY(!incidences.isEmpty());
+        QTest::newRow(qPrintable(name)) << incidences.constFirst();
+    }
+    QTest::newRow("busy-event") << makeBusyEvent();
+}
+
+void BenchmarkFormatter::initTestCase()
+{
+    QLocale::setDefault(QLocale(QStringLiteral("en_US")));
+
+    for (const QString &name : sCorpus) {
+        QVERIFY2(calendar(name), qPrintable(name));
+    }
+}
+
+void BenchmarkFormatter::benchmarkExtensiveDisplayStr_data()
+{
+    addCalendarRows();
+}
+
+void BenchmarkFormatter::benchmarkExtensiveDisplayStr()
+{
+    QFETCH(QString, name);
+    const Calendar::Ptr cal = calendar(name);
+    QVERIFY(cal);
+    const Incidence::List incidences = cal->incidences();
+
+    QBENCHMARK {
+        for (const Incidence::Ptr &incidence : incidences) {
+            const QString display = IncidenceFormatter::extensiveDisplayStr(cal, incidence);
+            Q_UNUSED(display)
+        }
+    }
+}
+
+void BenchmarkFormatter::benchmarkExtensiveDisplayStrs()
+{
+    const Calendar::Ptr cal = calendar(sLargeCalendarName);
+    QVERIFY(cal);
+    const Incidence::List incidences = cal->incidences();
+
+    QBENCHMARK {
+        const QStringList displays = IncidenceFormatter::extensiveDisplayStrs(cal, incidences);
+        QCOMPARE(displays.size(), incidences.size());
+    }
+}
+
+void BenchmarkFormatter::benchmarkToolTip_data()
+{
+    addCalendarRows();
+}
+
+void BenchmarkFormatter::benchmarkToolTip()
+{
+    QFETCH(QString, name);
+    const Calendar::Ptr cal = calendar(name);
+    QVERIFY(cal);
+    const Incidence::List incidences = cal->incidences();
+
+    QBENCHMARK {
+        for (const Incidence::Ptr &incidence : incidences) {
+            const QString toolTip = IncidenceFormatter::toolTipStr(QStringLiteral("Calendar"), incidence, QDate(), true);
+            Q_UNUSED(toolTip)
+        }
+    }
+}
+
+void BenchmarkFormatter::toolTipAllocations_data()
+{
+    addToolTipRows();
+}
+
+void BenchmarkFormatter::toolTipAllocations()
+{
+    QFETCH(Incidence::Ptr, incidence);
+
+    // Warm up lazily initialized state (icon loader, catalogs, ...)
+    QVERIFY(!IncidenceFormatter::toolTipStr(QStringLiteral("Calendar"), incidence, QDate(), true).isEmpty());
+
+    constexpr int iterations = 100;
+    const quint64 before = sAllocations.load();
+    for (int i = 0; i < iterations; ++i) {
+        const QString toolTip = IncidenceFormatter::toolTipStr(QStringLiteral("Calendar"), incidence, QDate(), true);
+        Q_UNUSED(toolTip)
+    }
+    const quint64 allocations = sAllocations.load() - before;
+
+    // Reported as "events" per tooltip
+    QTest::setBenchmarkResult(qreal(allocations) / iterations, QTest::Events);
+}
+
+void BenchmarkFormatter::benchmarkMailBodyStr_data()
+{
+    addCalendarRows();
+}
+
+void BenchmarkFormatter::benchmarkMailBodyStr()
+{
+    QFETCH(QString, name);
+    const Calendar::Ptr cal = calendar(name);
+    QVERIFY(cal);
+    const Incidence::List incidences = cal->incidences();
+
+    QBENCHMARK {
+        for (const Incidence::Ptr &incidence : incidences) {
+            const QString body = IncidenceFormatter::mailBodyStr(incidence);
+            Q_UNUSED(body)
+        }
+    }
+}
+
+void BenchmarkFormatter::benchmarkFormatICalInvitation_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<bool>("noHtml");
+
+    for (const QString &name : sInvitationCorpus) {
+        QTest::newRow(qPrintable(name + QLatin1StringView("-html"))) << name << false;
+        QTest::newRow(qPrintable(name + QLatin1StringView("-nohtml"))) << name << true;
+    }
+}
+
+void BenchmarkFormatter::benchmarkFormatICalInvitation()
+{
+    QFETCH(QString, name);
+    QFETCH(bool, noHtml);
+
+    QFile file(QStringLiteral(BENCHMARK_DATA_DIR "/%1.ical").arg(name));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QString invitation = QString::fromUtf8(file.readAll());
+
+    // Formatted against the large calendar, as a mail client would do
+    const Calendar::Ptr cal = calendar(sLargeCalendarName);
+    QVERIFY(cal);
+    InvitationFormatterHelper helper;
+
+    QBENCHMARK {
+        const QString html = noHtml ? IncidenceFormatter::formatICalInvitationNoHtml(invitation, cal, &helper, QString())
+                                    : IncidenceFormatter::formatICalInvitation(invitation, cal, &helper);
+        Q_UNUSED(html)
+    }
+}
+
+void BenchmarkFormatter::benchmarkRecurrenceString_data()
+{
+    addCalendarRows();
+}
+
+void BenchmarkFormatter::benchmarkRecurrenceString()
+{
+    QFETCH(QString, name);
+    const Calendar::Ptr cal = calendar(name);
+    QVERIFY(cal);
+    const Incidence::List incidences = cal->incidences();
+
+    QBENCHMARK {
+        for (const Incidence::Ptr &incidence : incidences) {
+            const QString recurrence = IncidenceFormatter::recurrenceString(incidence);
+            Q_UNUSED(recurrence)
+        }
+    }
+}
+
+void BenchmarkFormatter::benchmarkRecurrenceStringManyExDates_data()
+{
+    QTest::addColumn<Incidence::Ptr>("incidence");
+
+    const QDateTime start(QDate(2000, 1, 3), QTime(9, 0), QTimeZone::utc());
+    constexpr int exceptionCount = 10000;
+
+    const auto makeEvent = [&start]() {
+        const Event::Ptr event(new Event);
+        event->setDtStart(start);
+        event->setDtEnd(start.addSecs(30 * 60));
+        return event;
+    };
+
+    Event::Ptr event = makeEvent();
+    event->recurrence()->setDaily(1);
+    for (int i = 0; i < exceptionCount; ++i) {
+        event->recurrence()->addExDateTime(start.addDays(i));
+    }
+    QTest::newRow("daily-exdatetimes") << Incidence::Ptr(event);
+
+    event = makeEvent();
+    event->recurrence()->setDaily(1);
+    for (int i = 0; i < exceptionCount; ++i) {
+        event->recurrence()->addExDate(start.date().addDays(i));
+    }
+    QTest::newRow("daily-exdates") << Incidence::Ptr(event);
+
+    // Exchange style: the same few days excluded over and over
+    event = makeEvent();
+    event->recurrence()->setYearly(1);
+    for (int i = 0; i < exceptionCount; ++i) {
+        event->recurrence()->addExDateTime(start.addSecs(i));
+    }
+    QTest::newRow("yearly-duplicates") << Incidence::Ptr(event);
+}
+
+void BenchmarkFormatter::benchmarkRecurrenceStringManyExDates()
+{
+    QFETCH(Incidence::Ptr, incidence);
+
+    QBENCHMARK {
+        const QString recurrence = IncidenceFormatter::recurrenceString(incidence);
+        Q_UNUSED(recurrence)
+    }
+}
+
+void BenchmarkFormatter::benchmarkReminderStringList_data()
+{
+    addCalendarRows();
+}
+
+void BenchmarkFormatter::benchmarkReminderStringList()
+{
+    QFETCH(QString, name);
+    const Calendar::Ptr cal = calendar(name);
+    QVERIFY(cal);
+    const Incidence::List incidences = cal->incidences();
+
+    QBENCHMARK {
+        for (const Incidence::Ptr &incidence : incidences) {
+            const QStringList reminders = IncidenceFormatter::reminderStringList(incidence);
+            Q_UNUSED(reminders)
+        }
+    }
+}
+
+void BenchmarkFormatter::benchmarkDndCopyPaste_data()
+{
+    addCalendarRows();
+}
+
+void BenchmarkFormatter::benchmarkDndCopyPaste()
+{
+    QFETCH(QString, name);
+    const Calendar::Ptr cal = calendar(name);
+    QVERIFY(cal);
+    const Incidence::List incidences = cal->incidences();
+    const QDateTime target(QDate(2026, 6, 1), QTime(10, 0), QTimeZone::utc());
+
+    QBENCHMARK {
+        QVERIFY(DndFactory::copyIncidences(incidences));
+        const Incidence::List pasted = DndFactory::pasteIncidences(target);
+        QVERIFY(!pasted.isEmpty());
+    }
+}
+
+void BenchmarkFormatter::benchmarkDragRoundTrip_data()
+{
+    addCalendarRows();
+}
+
+void BenchmarkFormatter::benchmarkDragRoundTrip()
+{
+    QFETCH(QString, name);
+    const Calendar::Ptr cal = calendar(name);
+    QVERIFY(cal);
+
+    QBENCHMARK {
+        QMimeData mimeData;
+        QVERIFY(ICalDrag::populateMimeData(&mimeData, cal));
+        const Calendar::Ptr dropped = DndFactory::createDropCalendar(&mimeData);
+        QVERIFY(dropped);
+    }
+}
+
+#include "moc_benchmarkformatter.cpp"
@@ -0,0 +1,56 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <KCalendarCore/Calendar>
+
+#include <QHash>
+#include <QObject>
+
+class BenchmarkFormatter : public QObject
+{
+    Q_OBJECT
+
+private:
+    KCalendarCore::Calendar::Ptr calendar(const QString &name);
+    void addCalendarRows();
+
+    QHash<QString, KCalendarCore::Calendar::Ptr> mCalendars;
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkExtensiveDisplayStr_data();
+    void benchmarkExtensiveDisplayStr();
+    void benchmarkExtensiveDisplayStrs();
+
+    void benchmarkToolTip_data();
+    void benchmarkToolTip();
+    void toolTipAllocations_data();
+    void toolTipAllocations();
+
+    void benchmarkMailBodyStr_data();
+    void benchmarkMailBodyStr();
+
+    void benchmarkFormatICalInvitation_data();
+    void benchmarkFormatICalInvitation();
+
+    void benchmarkRecurrenceString_data();
+    void benchmarkRecurrenceString();
+    void benchmarkRecurrenceStringManyExDates_data();
+    void benchmarkRecurrenceStringManyExDates();
+
+    void benchmarkReminderStringList_data();
+    void benchmarkReminderStringList();
+
+    void benchmarkDndCopyPaste_data();
+    void benchmarkDndCopyPaste();
+    void benchmarkDragRoundTrip_data();
+    void benchmarkDragRoundTrip();
+};
@@ -0,0 +1,84 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "calendarmimedata_p.h"
+#include "icaldrag.h"
+#include "incidenceformatter.h"
+
+#include <KCalendarCore/ICalFormat>
+#include <KCalendarCore/MemoryCalendar>
+
+#include <QTimeZone>
+
+using namespace KCalendarCore;
+using namespace KCalUtils;
+
+CalendarMimeData::CalendarMimeData(const Incidence::List &incidences)
+{
+    mIncidences.reserve(incidences.size());
+    for (const Incidence::Ptr &incidence : incidences) {
+        if (incidence) {
+            mIncidences.append(Incidence::Ptr(incidence->clone()));
+        }
+    }
+}
+
+static const QStringList &calendarFormats()
+{
+    static const QStringList formats = {ICalDrag::mimeType(), QStringLiteral("text/html"), QStringLiteral("text/plain")};
+    return formats;
+}
+
+QStringList CalendarMimeData::formats() const
+{
+    return QMimeData::formats() << calendarFormats();
+}
+
+bool CalendarMimeData::hasFormat(const QString &mimeType) const
+{
+    return calendarFormats().contains(mimeType) || QMimeData::hasFormat(mimeType);
+}
+
+QVariant CalendarMimeData::retrieveData(const QString &mimeType, QMetaType type) const
+{
+    if (!calendarFormats().contains(mimeType)) {
+        return QMimeData::retrieveData(mimeType, type);
+    }
+
+    auto it = mData.constFind(mimeType);
+    if (it == mData.cend()) {
+        it = mData.insert(mimeType, createData(mimeType));
+    }
+    return *it;
+}
+
+QVariant CalendarMimeData::createData(const QString &mimeType) const
+{
+    if (mimeType == ICalDrag::mimeType()) {
+        const Calendar::Ptr calendar(new MemoryCalendar(QTimeZone::systemTimeZone()));
+        for (const Incidence::Ptr &incidence : std::as_const(mIncidences)) {
+            calendar->addIncidence(incidence);
+        }
+        ICalFormat format;
+        return format.toString(calendar).toUtf8();
+    }
+
+    QStringList texts;
+    texts.reserve(mIncidences.size());
+    if (mimeType == QLatin1StringView("text/html")) {
+        for (const Incidence::Ptr &incidence : std::as_const(mIncidences)) {
+            texts.append(IncidenceFormatter::extensiveDisplayStr(QString(), incidence));
+        }
+        return texts.join(QLatin1StringView("<hr/>"));
+    }
+
+    for (const Incidence::Ptr &incidence : std::as_const(mIncidences)) {
+        texts.append(IncidenceFormatter::mailBodyStr(incidence));
+    }
+    return texts.join(u'\n');
+}
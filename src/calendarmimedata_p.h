@@ -0,0 +1,46 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <KCalendarCore/Incidence>
+
+#include <QHash>
+#include <QMimeData>
+
+namespace KCalUtils
+{
+/*
+ * Mime data for copied or dragged incidences. It offers them as iCalendar,
+ * for calendar applications, as well as the text/html of the event viewer
+ * and the text/plain of mail bodies, for composers and editors. Each format
+ * is only generated once a consumer asks for it, e.g. when the user pastes,
+ * instead of when the selection is copied.
+ *
+ * The incidences are cloned on construction, so that later edits of the
+ * originals do not change what gets pasted.
+ */
+class CalendarMimeData : public QMimeData
+{
+public:
+    explicit CalendarMimeData(const KCalendarCore::Incidence::List &incidences);
+
+    [[nodiscard]] QStringList formats() const override;
+    [[nodiscard]] bool hasFormat(const QString &mimeType) const override;
+
+protected:
+    [[nodiscard]] QVariant retrieveData(const QString &mimeType, QMetaType type) const override;
+
+private:
+    [[nodiscard]] QVariant createData(const QString &mimeType) const;
+
+    KCalendarCore::Incidence::List mIncidences;
+    // The formats generated so far
+    mutable QHash<QString, QVariant> mData;
+};
+}
@@ -22,11 +22,14 @@
   @author Reinhold Kainhofer \<reinhold@kainhofer.com\>
 */
 #include "dndfactory.h"
+#include "calendarmimedata_p.h"
 #include "icaldrag.h"
 #include "vcaldrag.h"
 
 #include "kcalutils_debug.h"
+#include <KCalendarCore/ICalFormat>
 #include <KCalendarCore/MemoryCalendar>
+#include <KCalendarCore/VCalFormat>
 #include <QUrl>
 
 #include <QClipboard>
@@ -34,6 +37,9 @@
 #include <QGuiApplication>
 #include <QMimeData>
 #include <QTimeZone>
+#include <QtConcurrentMap>
+
+#include <algorithm>
 
 using namespace KCalendarCore;
 using namespace KCalUtils;
@@ -63,6 +69,7 @@ static Incidence::Ptr pasteIncidence(const Incidence::Ptr &incidence, QDateTime
     }
 
     if (inc && newDateTime.isValid()) {
+        QDateTime pastedDateTime;
         if (inc->type() == Incidence::TypeEvent) {
             Event::Ptr const event = inc.staticCast<Event>();
             if (pasteOptions & DndFactory::FlagPasteAtOriginalTime) {
@@ -83,6 +90,7 @@ static Incidence::Ptr pasteIncidence(const Incidence::Ptr &incidence, QDateTime
                 event->setDtStart(copyTimeSpec(newDateTime, event->dtStart()));
                 event->setDtEnd(copyTimeSpec(newDateTime.addSecs(durationInSeconds), event->dtEnd()));
             }
+            pastedDateTime = event->dtStart();
         } else if (inc->type() == Incidence::TypeTodo) {
             Todo::Ptr const aTodo = inc.staticCast<Todo>();
             const bool pasteAtDtStart = (pasteOptions & DndFactory::FlagTodosPasteAtDtStart);
@@ -94,8 +102,10 @@ static Incidence::Ptr pasteIncidence(const Incidence::Ptr &incidence, QDateTime
             }
             if (pasteAtDtStart) {
                 aTodo->setDtStart(copyTimeSpec(newDateTime, aTodo->dtStart()));
+                pastedDateTime = aTodo->dtStart();
             } else {
                 aTodo->setDtDue(copyTimeSpec(newDateTime, aTodo->dtDue()));
+                pastedDateTime = aTodo->dtDue();
             }
         } else if (inc->type() == Incidence::TypeJournal) {
             if (pasteOptions & DndFactory::FlagPasteAtOriginalTime) {
@@ -105,8 +115,15 @@ static Incidence::Ptr pasteIncidence(const Incidence::Ptr &incidence, QDateTime
                 newDateTime.setDate(date);
             }
             inc->setDtStart(copyTimeSpec(newDateTime, inc->dtStart()));
+            pastedDateTime = inc->dtStart();
         } else {
             qCDebug(KCALUTILS_LOG) << "Trying to paste unknown incidence of type" << int(inc->type());
+            return Incidence::Ptr();
+        }
+
+        if (!pastedDateTime.date().isValid()) {
+            qCDebug(KCALUTILS_LOG) << "Pasting" << incidence->uid() << "at" << newDateTime << "gives an invalid date";
+            return Incidence::Ptr();
         }
     }
 
@@ -114,74 +131,178 @@ static Incidence::Ptr pasteIncidence(const Incidence::Ptr &incidence, QDateTime
 }
 //@endcond
 
-Calendar::Ptr DndFactory::createDropCalendar(const QMimeData *mimeData)
+//@cond PRIVATE
+// Calls @p function with each line of @p data, including its line break, until it returns false
+template<typename Function>
+static void forEachLine(QByteArrayView data, Function function)
+{
+    while (!data.isEmpty()) {
+        const qsizetype end = data.indexOf('\n');
+        const QByteArrayView line = end < 0 ? data : data.first(end + 1);
+        if (!function(line)) {
+            return;
+        }
+        data = data.sliced(line.size());
+    }
+}
+
+[[nodiscard]] static bool startsWithNoCase(QByteArrayView line, QByteArrayView prefix)
+{
+    return line.size() >= prefix.size() && line.first(prefix.size()).compare(prefix, Qt::CaseInsensitive) == 0;
+}
+
+// The name of the component a BEGIN: or END: @p line opens or closes
+[[nodiscard]] static QByteArrayView componentName(QByteArrayView line)
+{
+    return line.sliced(line.indexOf(':') + 1).trimmed();
+}
+
+// Whether the calendar in @p data declares itself as vCalendar 1.0, which some
+// applications put in text/calendar
+[[nodiscard]] static bool isVCalendar(QByteArrayView data)
+{
+    bool vCalendar = false;
+    forEachLine(data, [&vCalendar](QByteArrayView line) {
+        if (startsWithNoCase(line, "VERSION:")) {
+            vCalendar = componentName(line) == "1.0";
+            return false;
+        }
+        // VERSION belongs before the first component
+        return !startsWithNoCase(line, "BEGIN:") || componentName(line).compare("VCALENDAR", Qt::CaseInsensitive) == 0;
+    });
+    return vCalendar;
+}
+
+// Cuts the first @p component, e.g. VEVENT, out of the calendar in @p data, with the
+// calendar properties and the time zones it may refer to, so that only that part
+// needs to be parsed. Returns an empty array if there is no such component.
+[[nodiscard]] static QByteArray firstComponent(QByteArrayView data, QByteArrayView component)
+{
+    QByteArray result;
+    bool found = false;
+    int depth = 0;
+    qsizetype componentStart = 0;
+    bool copyingComponent = false;
+    bool matchingComponent = false;
+    forEachLine(data, [&](QByteArrayView line) {
+        const bool begin = startsWithNoCase(line, "BEGIN:");
+        if (begin && ++depth == 2) {
+            const QByteArrayView name = componentName(line);
+            matchingComponent = !found && name.compare(component, Qt::CaseInsensitive) == 0;
+            copyingComponent = matchingComponent || name.compare("VTIMEZONE", Qt::CaseInsensitive) == 0;
+            componentStart = result.size();
+        }
+        if ((depth == 1 && !found) || copyingComponent) {
+            result.append(line);
+        }
+        if (!begin && startsWithNoCase(line, "END:") && depth-- == 2) {
+            copyingComponent = false;
+            if (matchingComponent) {
+                matchingComponent = false;
+                found = true;
+                // Time zones may also come after the component, look for them only if it uses any
+                return QByteArrayView(result).sliced(componentStart).contains("TZID=");
+            }
+        }
+        return true;
+    });
+    if (!found) {
+        return QByteArray();
+    }
+    result.append("END:VCALENDAR\r\n");
+    return result;
+}
+
+// Parses the incidences of @p payload into @p calendar, only the first @p component if set
+static bool decodeDropPayload(const QByteArray &payload, bool vCalendar, QByteArrayView component, const Calendar::Ptr &calendar)
 {
-    if (mimeData) {
-        Calendar::Ptr calendar(new MemoryCalendar(QTimeZone::systemTimeZone()));
+    const QByteArray data = component.isEmpty() ? payload : firstComponent(payload, component);
+    if (data.isEmpty()) {
+        return false;
+    }
+    if (vCalendar) {
+        VCalFormat format;
+        return format.fromRawString(calendar, data);
+    }
+    ICalFormat format;
+    return format.fromRawString(calendar, data);
+}
+
+static Calendar::Ptr decodeDropData(const QMimeData *mimeData, QByteArrayView component = {})
+{
+    if (!mimeData) {
+        return Calendar::Ptr();
+    }
 
-        if (ICalDrag::fromMimeData(mimeData, calendar) || VCalDrag::fromMimeData(mimeData, calendar)) {
+    Calendar::Ptr calendar(new MemoryCalendar(QTimeZone::systemTimeZone()));
+    if (ICalDrag::canDecode(mimeData)) {
+        const QByteArray payload = mimeData->data(ICalDrag::mimeType());
+        if (decodeDropPayload(payload, isVCalendar(payload), component, calendar)) {
             return calendar;
         }
     }
+    if (VCalDrag::canDecode(mimeData) && decodeDropPayload(mimeData->data(VCalDrag::mimeType()), true, component, calendar)) {
+        return calendar;
+    }
 
     return Calendar::Ptr();
 }
+//@endcond
 
-Event::Ptr DndFactory::createDropEvent(const QMimeData *mimeData)
+Calendar::Ptr DndFactory::createDropCalendar(const QMimeData *mimeData)
 {
-    // qCDebug(KCALUTILS_LOG);
-    Event::Ptr event;
-    Calendar::Ptr const calendar(createDropCalendar(mimeData));
+    return decodeDropData(mimeData);
+}
 
+Event::Ptr DndFactory::createDropEvent(const QMimeData *mimeData)
+{
+    // Only the first event is parsed, and returned as is since nothing else shares it
+    Calendar::Ptr const calendar(decodeDropData(mimeData, "VEVENT"));
     if (calendar) {
-        Event::List events = calendar->events();
+        const Event::List events = calendar->rawEvents();
         if (!events.isEmpty()) {
-            event = Event::Ptr(new Event(*events.first()));
+            return events.first();
         }
     }
-    return event;
+    return Event::Ptr();
 }
 
 Todo::Ptr DndFactory::createDropTodo(const QMimeData *mimeData)
 {
-    // qCDebug(KCALUTILS_LOG);
-    Todo::Ptr todo;
-    Calendar::Ptr const calendar(createDropCalendar(mimeData));
-
+    // Only the first to-do is parsed, and returned as is since nothing else shares it
+    Calendar::Ptr const calendar(decodeDropData(mimeData, "VTODO"));
     if (calendar) {
-        Todo::List todos = calendar->todos();
+        const Todo::List todos = calendar->rawTodos();
         if (!todos.isEmpty()) {
-            todo = Todo::Ptr(new Todo(*todos.first()));
+            return todos.first();
         }
     }
+    return Todo::Ptr();
+}
 
-    return todo;
+QMimeData *DndFactory::createMimeData(const Incidence::List &incidences)
+{
+    const bool empty = std::none_of(incidences.cbegin(), incidences.cend(), [](const Incidence::Ptr &incidence) {
+        return !incidence.isNull();
+    });
+    if (empty) {
+        return nullptr;
+    }
+    return new CalendarMimeData(incidences);
 }
 
 bool DndFactory::copyIncidences(const Incidence::List &incidences)
 {
     QClipboard *clipboard = QGuiApplication::clipboard();
     Q_ASSERT(clipboard);
-    Calendar::Ptr const calendar(new MemoryCalendar(QTimeZone::systemTimeZone()));
-
-    Incidence::List::ConstIterator it;
-    const Incidence::List::ConstIterator end(incidences.constEnd());
-    for (it = incidences.constBegin(); it != end; ++it) {
-        if (*it) {
-            calendar->addIncidence(Incidence::Ptr((*it)->clone()));
-        }
-    }
 
-    auto mimeData = new QMimeData;
-
-    ICalDrag::populateMimeData(mimeData, calendar);
-
-    if (calendar->incidences().isEmpty()) {
+    // The incidences are only serialized once someone pastes them
+    QMimeData *mimeData = createMimeData(incidences);
+    if (!mimeData) {
         return false;
-    } else {
-        clipboard->setMimeData(mimeData);
-        return true;
     }
+    clipboard->setMimeData(mimeData);
+    return true;
 }
 
 Incidence::List DndFactory::pasteIncidences(const QDateTime &newDateTime, PasteFlags pasteOptions)
@@ -189,40 +310,59 @@ Incidence::List DndFactory::pasteIncidences(const QDateTime &newDateTime, PasteF
     QClipboard const *clipboard = QGuiApplication::clipboard();
     Q_ASSERT(clipboard);
     Calendar::Ptr const calendar(createDropCalendar(clipboard->mimeData()));
-    Incidence::List list;
 
     if (!calendar) {
         qCDebug(KCALUTILS_LOG) << "Can't parse clipboard";
-        return list;
+        return Incidence::List();
     }
 
-    // All pasted incidences get new uids, must keep track of old uids,
-    // so we can update child's parents
-    QHash<QString, Incidence::Ptr> oldUidToNewInc;
+    return pasteIncidences(calendar, newDateTime, pasteOptions);
+}
+
+Incidence::List DndFactory::pasteIncidences(const Calendar::Ptr &calendar, const QDateTime &newDateTime, PasteFlags pasteOptions, QStringList *failedUids)
+{
+    if (!calendar) {
+        return Incidence::List();
+    }
 
-    Incidence::List::ConstIterator it;
     const Incidence::List incidences = calendar->incidences();
-    Incidence::List::ConstIterator end(incidences.constEnd());
-    for (it = incidences.constBegin(); it != end; ++it) {
-        Incidence::Ptr const incidence = pasteIncidence(*it, newDateTime, pasteOptions);
-        if (incidence) {
-            list.append(incidence);
-            oldUidToNewInc[(*it)->uid()] = *it;
+
+    // Cloning and moving the incidences is independent for each of them,
+    // spread it over the thread pool once it is worth the overhead.
+    const auto paste = [&newDateTime, pasteOptions](const Incidence::Ptr &incidence) {
+        return pasteIncidence(incidence, newDateTime, pasteOptions);
+    };
+    constexpr qsizetype parallelThreshold = 256;
+    Incidence::List pasted;
+    if (incidences.size() < parallelThreshold) {
+        pasted.reserve(incidences.size());
+        for (const Incidence::Ptr &incidence : incidences) {
+            pasted.append(paste(incidence));
         }
+    } else {
+        pasted = QtConcurrent::blockingMapped(incidences, paste);
     }
 
-    // update relations
-    end = list.constEnd();
-    for (it = list.constBegin(); it != end; ++it) {
-        const Incidence::Ptr &incidence = *it;
-        if (oldUidToNewInc.contains(incidence->relatedTo())) {
-            Incidence::Ptr const parentInc = oldUidToNewInc[incidence->relatedTo()];
-            incidence->setRelatedTo(parentInc->uid());
-        } else {
-            // not related to anything in the clipboard
-            incidence->setRelatedTo(QString());
+    // All pasted incidences get new uids, must keep track of old uids,
+    // so we can update child's parents
+    QHash<QString, QString> oldUidToNewUid;
+    oldUidToNewUid.reserve(incidences.size());
+    Incidence::List list;
+    list.reserve(incidences.size());
+    for (qsizetype i = 0; i < incidences.size(); ++i) {
+        if (pasted.at(i)) {
+            oldUidToNewUid.insert(incidences.at(i)->uid(), pasted.at(i)->uid());
+            list.append(pasted.at(i));
+        } else if (failedUids) {
+            failedUids->append(incidences.at(i)->uid());
         }
     }
 
+    // update relations
+    for (const Incidence::Ptr &incidence : std::as_const(list)) {
+        // not related to anything in the clipboard if not found
+        incidence->setRelatedTo(oldUidToNewUid.value(incidence->relatedTo()));
+    }
+
     return list;
 }
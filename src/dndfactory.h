@@ -70,6 +70,22 @@ public:
     */
     static KCalendarCore::Event::Ptr createDropEvent(const QMimeData *mimeData);
 
+    /*!
+      Create the mime data to drag or copy \a incidences, e.g. for a QDrag.
+
+      The data holds the incidences as iCalendar, as text/html formatted
+      like IncidenceFormatter::extensiveDisplayStr() and as text/plain
+      formatted like IncidenceFormatter::mailBodyStr(). The incidences are
+      cloned right away, but each format is only generated when it is
+      requested, so creating it for a large selection is cheap.
+
+      Returns the mime data, owned by the caller, or null if \a incidences
+      has no valid incidence.
+
+      \since 6.9
+    */
+    static QMimeData *createMimeData(const KCalendarCore::Incidence::List &incidences);
+
     /*!
       Copies a list of \a incidences to the clipboard.
     */
@@ -90,5 +106,26 @@ public:
       Returns the cloned incidence.
     */
     static KCalendarCore::Incidence::List pasteIncidences(const QDateTime &newDateTime = QDateTime(), PasteFlags pasteOptions = PasteFlags());
+
+    /*!
+      Clones the incidences of \a calendar, e.g. a calendar from createDropCalendar(),
+      like pasteIncidences() does with the incidences in the clipboard.
+
+      The clones get new uids and the relations between the incidences are kept,
+      so that whole to-do trees can be pasted. Large sets of incidences are
+      cloned concurrently.
+
+      \a newDateTime and \a pasteOptions are used as in pasteIncidences().
+      If \a failedUids is not null, the uids of the incidences that could not
+      be pasted are appended to it.
+
+      Returns the cloned incidences.
+
+      \since 6.9
+    */
+    static KCalendarCore::Incidence::List pasteIncidences(const KCalendarCore::Calendar::Ptr &calendar,
+                                                          const QDateTime &newDateTime = QDateTime(),
+                                                          PasteFlags pasteOptions = PasteFlags(),
+                                                          QStringList *failedUids = nullptr);
 };
 }
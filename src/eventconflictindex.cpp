@@ -0,0 +1,220 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "eventconflictindex_p.h"
+
+#include <QMutexLocker>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <limits>
+
+using namespace KCalUtils;
+using namespace KCalendarCore;
+
+static constexpr qint64 msecsPerDay = 24 * 60 * 60 * 1000;
+
+EventConflictIndex::EventConflictIndex(const Calendar::Ptr &calendar)
+{
+    attach(calendar);
+}
+
+EventConflictIndex::~EventConflictIndex()
+{
+    detach();
+}
+
+void EventConflictIndex::attach(const Calendar::Ptr &calendar)
+{
+    const QMutexLocker locker(&mMutex);
+    if (calendar && mCalendar.toStrongRef() == calendar) {
+        return;
+    }
+
+    reset();
+    if (!calendar) {
+        return;
+    }
+
+    mCalendar = calendar;
+    const Event::List events = calendar->rawEvents();
+    mSpans.reserve(events.size());
+    for (const Event::Ptr &event : events) {
+        insert(event);
+    }
+    calendar->registerObserver(this);
+}
+
+void EventConflictIndex::detach()
+{
+    const QMutexLocker locker(&mMutex);
+    reset();
+}
+
+void EventConflictIndex::reset()
+{
+    // The calendar may already be gone, it then no longer knows about us either
+    if (const Calendar::Ptr calendar = mCalendar.toStrongRef()) {
+        calendar->unregisterObserver(this);
+    }
+    mCalendar.clear();
+    mEvents.clear();
+    mRecurringEvents.clear();
+    mSpans.clear();
+}
+
+bool EventConflictIndex::isAttachedTo(const Calendar::Ptr &calendar) const
+{
+    const QMutexLocker locker(&mMutex);
+    return mCalendar.toStrongRef() == calendar;
+}
+
+Event::List EventConflictIndex::overlapping(const QDateTime &start, const QDateTime &end) const
+{
+    Event::List result;
+    if (!start.isValid() || !end.isValid() || end < start) {
+        return result;
+    }
+
+    const qint64 startMSecs = start.toMSecsSinceEpoch();
+    const qint64 endMSecs = end.toMSecsSinceEpoch();
+
+    const QMutexLocker locker(&mMutex);
+
+    for (auto group = mEvents.cbegin(); group != mEvents.cend(); ++group) {
+        // No event of the group starting before startMSecs - longest can reach the interval
+        const qint64 longest = group.key() == 0 ? 0 : static_cast<qint64>((quint64(1) << group.key()) - 1);
+        const qint64 first = startMSecs >= std::numeric_limits<qint64>::min() + longest ? startMSecs - longest : std::numeric_limits<qint64>::min();
+        const auto last = group->upperBound(endMSecs);
+        for (auto it = group->lowerBound(first); it != last; ++it) {
+            if (mSpans.value(it->data()).end >= startMSecs) {
+                result.append(*it);
+            }
+        }
+    }
+
+    // Series which ended before the interval are not looked at
+    for (auto it = mRecurringEvents.lowerBound(startMSecs); it != mRecurringEvents.cend(); ++it) {
+        if (mSpans.value(it->data()).start <= endMSecs) {
+            result.append(*it);
+        }
+    }
+
+    std::stable_sort(result.begin(), result.end(), [](const Event::Ptr &lhs, const Event::Ptr &rhs) {
+        return lhs->dtStart() < rhs->dtStart();
+    });
+    return result;
+}
+
+qsizetype EventConflictIndex::size() const
+{
+    const QMutexLocker locker(&mMutex);
+    return mSpans.size();
+}
+
+void EventConflictIndex::calendarIncidenceAdded(const Incidence::Ptr &incidence)
+{
+    const QMutexLocker locker(&mMutex);
+    insert(incidence);
+}
+
+void EventConflictIndex::calendarIncidenceChanged(const Incidence::Ptr &incidence)
+{
+    const QMutexLocker locker(&mMutex);
+    remove(incidence);
+    insert(incidence);
+}
+
+void EventConflictIndex::calendarIncidenceDeleted(const Incidence::Ptr &incidence, [[maybe_unused]] const Calendar *calendar)
+{
+    const QMutexLocker locker(&mMutex);
+    remove(incidence);
+}
+
+EventConflictIndex::Span EventConflictIndex::span(const Event::Ptr &event)
+{
+    Span span;
+    const QDateTime dtStart = event->dtStart();
+    span.start = dtStart.toMSecsSinceEpoch();
+    span.recurs = event->recurs();
+
+    // How long a single occurrence lasts, all-day events end at the end of their last day
+    qint64 length = 0;
+    if (event->hasEndDate()) {
+        length = std::max<qint64>(0, dtStart.msecsTo(event->dtEnd()));
+    } else if (event->hasDuration()) {
+        length = std::max<qint64>(0, event->duration().asSeconds() * 1000);
+    }
+    if (event->allDay()) {
+        length += msecsPerDay;
+    }
+
+    if (!span.recurs) {
+        span.end = span.start + length;
+    } else {
+        // Recurrences without end have an invalid end date/time
+        const QDateTime lastStart = event->recurrence()->endDateTime();
+        span.end = lastStart.isValid() ? lastStart.toMSecsSinceEpoch() + length : std::numeric_limits<qint64>::max();
+    }
+    return span;
+}
+
+int EventConflictIndex::lengthGroup(qint64 length)
+{
+    // The number of bits of the length, lengths of group n are below 2^n
+    return length == 0 ? 0 : 64 - qCountLeadingZeroBits(static_cast<quint64>(length));
+}
+
+void EventConflictIndex::insert(const Incidence::Ptr &incidence)
+{
+    if (!incidence || incidence->type() != Incidence::TypeEvent || mSpans.contains(incidence.data())) {
+        return;
+    }
+    const Event::Ptr event = incidence.staticCast<Event>();
+    if (!event->dtStart().isValid()) {
+        return;
+    }
+
+    const Span span = EventConflictIndex::span(event);
+    if (span.recurs) {
+        mRecurringEvents.insert(span.end, event);
+    } else {
+        mEvents[lengthGroup(span.end - span.start)].insert(span.start, event);
+    }
+    mSpans.insert(incidence.data(), span);
+}
+
+void EventConflictIndex::remove(const Incidence::Ptr &incidence)
+{
+    const auto spanIt = mSpans.constFind(incidence.data());
+    if (spanIt == mSpans.cend()) {
+        return;
+    }
+
+    const Span span = *spanIt;
+    const auto erase = [&incidence](QMultiMap<qint64, Event::Ptr> &events, qint64 key) {
+        for (auto it = events.find(key); it != events.end() && it.key() == key; ++it) {
+            if (it->data() == incidence.data()) {
+                events.erase(it);
+                break;
+            }
+        }
+    };
+    if (span.recurs) {
+        erase(mRecurringEvents, span.end);
+    } else {
+        const auto group = mEvents.find(lengthGroup(span.end - span.start));
+        if (group != mEvents.end()) {
+            erase(*group, span.start);
+            if (group->isEmpty()) {
+                mEvents.erase(group);
+            }
+        }
+    }
+    mSpans.erase(spanIt);
+}
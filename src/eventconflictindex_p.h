@@ -0,0 +1,97 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kcalutils_private_export.h"
+
+#include <KCalendarCore/Calendar>
+#include <KCalendarCore/Event>
+
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QMultiMap>
+#include <QMutex>
+#include <QWeakPointer>
+
+namespace KCalUtils
+{
+/*
+ * Indexes the events of a calendar by the time span they cover, so that the
+ * events overlapping an interval can be found without asking every event of
+ * the calendar for its occurrences.
+ *
+ * Single events are grouped by the power of two their length rounds up to,
+ * and sorted by start within each group. A query looks at the events of each
+ * group starting at most the longest length of the group before the interval,
+ * so one long event does not make the short ones be scanned from far back.
+ * Recurring events are kept apart, sorted by the end of their last occurrence
+ * and with those recurring forever last. A query scans the series that still
+ * run at the start of the interval, which it returns unless they only start
+ * after its end.
+ *
+ * Once attached, the index observes the calendar and follows additions,
+ * changes and removals of events. All members lock the index, so that
+ * queries from other threads are safe while the calendar notifies changes.
+ */
+class KCALUTILS_TESTS_EXPORT EventConflictIndex : public KCalendarCore::Calendar::CalendarObserver
+{
+public:
+    EventConflictIndex() = default;
+    explicit EventConflictIndex(const KCalendarCore::Calendar::Ptr &calendar);
+    ~EventConflictIndex() override;
+
+    /*
+     * Indexes @p calendar and keeps the index up to date until another
+     * calendar is attached. Does nothing when @p calendar is already attached.
+     */
+    void attach(const KCalendarCore::Calendar::Ptr &calendar);
+    void detach();
+    [[nodiscard]] bool isAttachedTo(const KCalendarCore::Calendar::Ptr &calendar) const;
+
+    /*
+     * Returns the events whose span intersects [@p start, @p end], sorted by
+     * start. Recurring events are returned when the range of their recurrence
+     * does, callers still have to check whether one occurrence actually falls
+     * into the interval.
+     */
+    [[nodiscard]] KCalendarCore::Event::List overlapping(const QDateTime &start, const QDateTime &end) const;
+    [[nodiscard]] qsizetype size() const;
+
+protected:
+    void calendarIncidenceAdded(const KCalendarCore::Incidence::Ptr &incidence) override;
+    void calendarIncidenceChanged(const KCalendarCore::Incidence::Ptr &incidence) override;
+    void calendarIncidenceDeleted(const KCalendarCore::Incidence::Ptr &incidence, const KCalendarCore::Calendar *calendar) override;
+
+private:
+    Q_DISABLE_COPY(EventConflictIndex)
+
+    struct Span {
+        qint64 start = 0;
+        qint64 end = 0;
+        bool recurs = false;
+    };
+
+    [[nodiscard]] static Span span(const KCalendarCore::Event::Ptr &event);
+    [[nodiscard]] static int lengthGroup(qint64 length);
+    // Expect mMutex to be locked
+    void reset();
+    void insert(const KCalendarCore::Incidence::Ptr &incidence);
+    void remove(const KCalendarCore::Incidence::Ptr &incidence);
+
+    mutable QMutex mMutex;
+    QWeakPointer<KCalendarCore::Calendar> mCalendar;
+    // Single events keyed by length group, then by start in msecs since epoch
+    QMap<int, QMultiMap<qint64, KCalendarCore::Event::Ptr>> mEvents;
+    // Keyed by the end of their last occurrence in msecs since epoch
+    QMultiMap<qint64, KCalendarCore::Event::Ptr> mRecurringEvents;
+    // The span each event was indexed with, its dates may change afterwards
+    QHash<const KCalendarCore::Incidence *, Span> mSpans;
+};
+}
@@ -0,0 +1,176 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "formatterlabels_p.h"
+#include "localecache_p.h"
+
+#include <KLocalizedString>
+
+#include <QLocale>
+
+using namespace KCalUtils;
+
+Q_GLOBAL_STATIC(LocaleCache<FormatterLabels>, sFormatterLabels)
+Q_GLOBAL_STATIC(LocaleCache<RecurrenceLabels>, sRecurrenceLabels)
+
+// Substituted for the argument, so that the translated pattern keeps its placeholder
+static QString placeholder()
+{
+    return QStringLiteral("%1");
+}
+
+FormatterLabels::FormatterLabels()
+    : calendar(i18n("Calendar:"))
+    , location(i18n("Location:"))
+    , duration(i18n("Duration:"))
+    , recurrence(i18n("Recurrence:"))
+    , exception(i18n("Exception"))
+    , description(i18n("Description:"))
+    , organizer(i18n("Organizer:"))
+    , chair(i18n("Chair:"))
+    , requiredParticipants(i18n("Required Participants:"))
+    , optionalParticipants(i18n("Optional Participants:"))
+    , observers(i18n("Observers:"))
+    , ellipsis(i18nc("ellipsis", "..."))
+    , delegatedByPattern(i18n(" (delegated by %1)", placeholder()))
+    , delegatedToPattern(i18n(" (delegated to %1)", placeholder()))
+    , summaryLinePattern(i18n("Summary: %1\n", placeholder()))
+    , organizerLinePattern(i18n("Organizer: %1\n", placeholder()))
+    , locationLinePattern(i18n("Location: %1\n", placeholder()))
+    , beforeStartPattern(i18nc("N days/hours/minutes before the start datetime", "%1 before the start", placeholder()))
+    , afterStartPattern(i18nc("N days/hours/minutes after the start datetime", "%1 after the start", placeholder()))
+    , beforeDuePattern(i18nc("N days/hours/minutes before the due datetime", "%1 before the to-do is due", placeholder()))
+    , afterDuePattern(i18nc("N days/hours/minutes after the due datetime", "%1 after the to-do is due", placeholder()))
+    , beforeEndPattern(i18nc("N days/hours/minutes before the end datetime", "%1 before the end", placeholder()))
+    , afterEndPattern(i18nc("N days/hours/minutes after the end datetime", "%1 after the end", placeholder()))
+    , atPattern(i18nc("reminder occurs at datetime", "at %1", placeholder()))
+    , intervalPattern(i18nc("interval is N days/hours/minutes", "interval is %1", placeholder()))
+    , alarmDisabled(i18nc("alarm is disabled", "disabled"))
+    , eventPublished(i18n("This invitation has been published."))
+    , eventCreatedByMe(i18n("I created this invitation."))
+    , eventRefreshed(i18n("This invitation was refreshed."))
+    , eventCanceled(i18n("This invitation has been canceled."))
+    , eventRevoked(i18n("The organizer has revoked the invitation."))
+    , eventAddition(i18n("Addition to the invitation."))
+    , eventCompleted(i18n("This invitation is now completed."))
+    , eventUnknownResponse(i18n("Unknown response to this invitation."))
+    , todoPublished(i18n("This to-do has been published."))
+    , todoCreatedByMe(i18n("I created this to-do."))
+    , todoRefreshed(i18n("This to-do was refreshed."))
+    , todoCanceled(i18n("This to-do was canceled."))
+    , todoRevoked(i18n("The organizer has revoked this to-do."))
+    , todoAddition(i18n("Addition to the to-do."))
+    , todoCompleted(i18n("The request for this to-do is now completed."))
+    , todoUnknownResponse(i18n("Unknown response to this to-do."))
+{
+}
+
+std::shared_ptr<const FormatterLabels> FormatterLabels::get()
+{
+    return sFormatterLabels()->get();
+}
+
+RecurrenceLabels::RecurrenceLabels()
+    : noRecurrence(i18n("No recurrence"))
+    , daySeparator(i18nc("separator for list of days", ", "))
+    , noDays(i18nc("Recurs weekly on no days", "no days"))
+{
+    dayList.reserve(63);
+    dayList.append(i18n("31st Last"));
+    dayList.append(i18n("30th Last"));
+    dayList.append(i18n("29th Last"));
+    dayList.append(i18n("28th Last"));
+    dayList.append(i18n("27th Last"));
+    dayList.append(i18n("26th Last"));
+    dayList.append(i18n("25th Last"));
+    dayList.append(i18n("24th Last"));
+    dayList.append(i18n("23rd Last"));
+    dayList.append(i18n("22nd Last"));
+    dayList.append(i18n("21st Last"));
+    dayList.append(i18n("20th Last"));
+    dayList.append(i18n("19th Last"));
+    dayList.append(i18n("18th Last"));
+    dayList.append(i18n("17th Last"));
+    dayList.append(i18n("16th Last"));
+    dayList.append(i18n("15th Last"));
+    dayList.append(i18n("14th Last"));
+    dayList.append(i18n("13th Last"));
+    dayList.append(i18n("12th Last"));
+    dayList.append(i18n("11th Last"));
+    dayList.append(i18n("10th Last"));
+    dayList.append(i18n("9th Last"));
+    dayList.append(i18n("8th Last"));
+    dayList.append(i18n("7th Last"));
+    dayList.append(i18n("6th Last"));
+    dayList.append(i18n("5th Last"));
+    dayList.append(i18n("4th Last"));
+    dayList.append(i18n("3rd Last"));
+    dayList.append(i18n("2nd Last"));
+    dayList.append(i18nc("last day of the month", "Last"));
+    dayList.append(i18nc("unknown day of the month", "unknown")); // #31 - zero offset from UI
+    dayList.append(i18n("1st"));
+    dayList.append(i18n("2nd"));
+    dayList.append(i18n("3rd"));
+    dayList.append(i18n("4th"));
+    dayList.append(i18n("5th"));
+    dayList.append(i18n("6th"));
+    dayList.append(i18n("7th"));
+    dayList.append(i18n("8th"));
+    dayList.append(i18n("9th"));
+    dayList.append(i18n("10th"));
+    dayList.append(i18n("11th"));
+    dayList.append(i18n("12th"));
+    dayList.append(i18n("13th"));
+    dayList.append(i18n("14th"));
+    dayList.append(i18n("15th"));
+    dayList.append(i18n("16th"));
+    dayList.append(i18n("17th"));
+    dayList.append(i18n("18th"));
+    dayList.append(i18n("19th"));
+    dayList.append(i18n("20th"));
+    dayList.append(i18n("21st"));
+    dayList.append(i18n("22nd"));
+    dayList.append(i18n("23rd"));
+    dayList.append(i18n("24th"));
+    dayList.append(i18n("25th"));
+    dayList.append(i18n("26th"));
+    dayList.append(i18n("27th"));
+    dayList.append(i18n("28th"));
+    dayList.append(i18n("29th"));
+    dayList.append(i18n("30th"));
+    dayList.append(i18n("31st"));
+
+    const QLocale locale;
+    for (int day = 1; day <= 7; ++day) {
+        mShortDayNames[day - 1] = locale.dayName(day, QLocale::ShortFormat);
+        mLongDayNames[day - 1] = locale.dayName(day, QLocale::LongFormat);
+    }
+    for (int month = 1; month <= 12; ++month) {
+        mLongMonthNames[month - 1] = locale.monthName(month, QLocale::LongFormat);
+    }
+}
+
+std::shared_ptr<const RecurrenceLabels> RecurrenceLabels::get()
+{
+    return sRecurrenceLabels()->get();
+}
+
+QString RecurrenceLabels::shortDayName(int day) const
+{
+    return day >= 1 && day <= 7 ? mShortDayNames[day - 1] : QString();
+}
+
+QString RecurrenceLabels::longDayName(int day) const
+{
+    return day >= 1 && day <= 7 ? mLongDayNames[day - 1] : QString();
+}
+
+QString RecurrenceLabels::longMonthName(int month) const
+{
+    return month >= 1 && month <= 12 ? mLongMonthNames[month - 1] : QString();
+}
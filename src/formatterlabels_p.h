@@ -0,0 +1,114 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kcalutils_private_export.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <array>
+#include <memory>
+
+namespace KCalUtils
+{
+/*
+ * Translations of the constant labels used by the formatters, looked up once
+ * per locale instead of once per formatted incidence. Members ending in
+ * "Pattern" contain a %1 placeholder to be filled with QString::arg().
+ */
+struct KCALUTILS_TESTS_EXPORT FormatterLabels {
+    FormatterLabels();
+
+    /*
+     * Returns the table for the current languages and locale.
+     */
+    [[nodiscard]] static std::shared_ptr<const FormatterLabels> get();
+
+    // Tooltips
+    QString calendar;
+    QString location;
+    QString duration;
+    QString recurrence;
+    QString exception;
+    QString description;
+    QString organizer;
+    QString chair;
+    QString requiredParticipants;
+    QString optionalParticipants;
+    QString observers;
+    QString ellipsis;
+    QString delegatedByPattern;
+    QString delegatedToPattern;
+
+    // Mail body
+    QString summaryLinePattern;
+    QString organizerLinePattern;
+    QString locationLinePattern;
+
+    // Reminders
+    QString beforeStartPattern;
+    QString afterStartPattern;
+    QString beforeDuePattern;
+    QString afterDuePattern;
+    QString beforeEndPattern;
+    QString afterEndPattern;
+    QString atPattern;
+    QString intervalPattern;
+    QString alarmDisabled;
+
+    // Invitation headers
+    QString eventPublished;
+    QString eventCreatedByMe;
+    QString eventRefreshed;
+    QString eventCanceled;
+    QString eventRevoked;
+    QString eventAddition;
+    QString eventCompleted;
+    QString eventUnknownResponse;
+    QString todoPublished;
+    QString todoCreatedByMe;
+    QString todoRefreshed;
+    QString todoCanceled;
+    QString todoRevoked;
+    QString todoAddition;
+    QString todoCompleted;
+    QString todoUnknownResponse;
+};
+
+/*
+ * Translated ordinals, weekday and month names used by
+ * IncidenceFormatter::recurrenceString(), looked up once per locale.
+ */
+struct KCALUTILS_TESTS_EXPORT RecurrenceLabels {
+    RecurrenceLabels();
+
+    /*
+     * Returns the table for the current languages and locale.
+     */
+    [[nodiscard]] static std::shared_ptr<const RecurrenceLabels> get();
+
+    // 1 to 7, Monday first like QLocale::dayName(); empty when out of range
+    [[nodiscard]] QString shortDayName(int day) const;
+    [[nodiscard]] QString longDayName(int day) const;
+    // 1 to 12; empty when out of range
+    [[nodiscard]] QString longMonthName(int month) const;
+
+    // "31st Last" ... "Last", "unknown", "1st" ... "31st", index with offset + 31
+    QStringList dayList;
+    QString noRecurrence;
+    QString daySeparator;
+    QString noDays;
+
+private:
+    std::array<QString, 7> mShortDayNames;
+    std::array<QString, 7> mLongDayNames;
+    std::array<QString, 12> mLongMonthNames;
+};
+}
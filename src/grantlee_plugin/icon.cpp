@@ -6,6 +6,7 @@
  */
 
 #include "icon.h"
+#include "iconloader_p.h"
 
 #include <KTextTemplate/Exception>
 #include <KTextTemplate/Parser>
@@ -110,7 +111,8 @@ void IconNode::render(KTextTemplate::OutputStream *stream, [[maybe_unused]] KTex
         }
     }
 
-    QString iconPath = KIconLoader::global()->iconPath(iconName, mSizeOrGroup < KIconLoader::LastGroup ? mSizeOrGroup : -mSizeOrGroup);
+    // Templates may be rendered from worker threads, so go through the serialized icon lookup
+    QString iconPath = KCalUtils::iconPath(iconName, mSizeOrGroup < KIconLoader::LastGroup ? mSizeOrGroup : -mSizeOrGroup);
     if (iconPath.startsWith(QLatin1StringView(":/"))) {
         iconPath = QStringLiteral("qrc") + iconPath;
     } else {
@@ -120,7 +122,7 @@ void IconNode::render(KTextTemplate::OutputStream *stream, [[maybe_unused]] KTex
     const QString html =
         QStringLiteral("<img src=\"%1\" align=\"top\" height=\"%2\" width=\"%2\" alt=\"%3\" title=\"%4\" />")
             .arg(iconPath)
-            .arg(mSizeOrGroup < KIconLoader::LastGroup ? KIconLoader::global()->currentSize(static_cast<KIconLoader::Group>(mSizeOrGroup)) : mSizeOrGroup)
+            .arg(mSizeOrGroup < KIconLoader::LastGroup ? KCalUtils::iconCurrentSize(mSizeOrGroup) : mSizeOrGroup)
             .arg(altText.isEmpty() ? iconName : altText, altText); // title is intentionally blank if no alt is provided
     (*stream) << KTextTemplate::SafeString(html, KTextTemplate::SafeString::IsSafe);
 }
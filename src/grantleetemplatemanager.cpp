@@ -10,28 +10,43 @@
 #include "grantleeki18nlocalizer_p.h"
 #include "grantleetemplatemanager_p.h"
 
+#include <KTextTemplate/CachingLoaderDecorator>
 #include <KTextTemplate/Engine>
 #include <KTextTemplate/Template>
 #include <KTextTemplate/TemplateLoader>
+#include <QAtomicInt>
 #include <QDebug>
+#include <QMutex>
 #include <QStandardPaths>
 #include <QString>
+#include <QThreadStorage>
 
 #include <KLocalizedString>
 
 using namespace Qt::Literals;
 
-GrantleeTemplateManager *GrantleeTemplateManager::sInstance = nullptr;
+namespace
+{
+// Plugin paths added through setPluginPath(), shared by the managers of all threads
+struct PluginPathSettings {
+    QMutex mutex;
+    QStringList extraPaths;
+    QAtomicInt generation = 0;
+};
+}
+
+Q_GLOBAL_STATIC(PluginPathSettings, sPluginPathSettings)
+Q_GLOBAL_STATIC(QThreadStorage<GrantleeTemplateManager *>, sInstances)
 
 GrantleeTemplateManager::GrantleeTemplateManager()
     : mEngine(new KTextTemplate::Engine)
     , mLoader(new KTextTemplate::FileSystemTemplateLoader)
+    , mCachingLoader(new KTextTemplate::CachingLoaderDecorator(mLoader))
     , mLocalizer(new GrantleeKi18nLocalizer)
 {
     mLoader->setTemplateDirs({u":/"_s});
 
-    mEngine->addTemplateLoader(mLoader);
-    mEngine->addPluginPath(QStringLiteral(GRANTLEE_PLUGIN_INSTALL_DIR));
+    mEngine->addTemplateLoader(mCachingLoader);
     mEngine->addDefaultLibrary(QStringLiteral("ktexttemplate_i18ntags"));
     mEngine->addDefaultLibrary(QStringLiteral("kcalendar_grantlee_plugin"));
     mEngine->setSmartTrimEnabled(true);
@@ -44,18 +59,63 @@ GrantleeTemplateManager::~GrantleeTemplateManager()
 
 GrantleeTemplateManager *GrantleeTemplateManager::instance()
 {
-    if (!sInstance) {
-        sInstance = new GrantleeTemplateManager;
+    QThreadStorage<GrantleeTemplateManager *> *const instances = sInstances();
+    if (!instances->hasLocalData()) {
+        // QThreadStorage takes ownership and deletes the manager when the thread exits
+        instances->setLocalData(new GrantleeTemplateManager);
     }
-    return sInstance;
+    GrantleeTemplateManager *const manager = instances->localData();
+    manager->syncPluginPaths();
+    return manager;
 }
 
 void GrantleeTemplateManager::setPluginPath(const QString &path)
 {
-    QStringList pluginPaths = mEngine->pluginPaths();
-    pluginPaths.prepend(path);
+    {
+        PluginPathSettings *const settings = sPluginPathSettings();
+        const QMutexLocker locker(&settings->mutex);
+        settings->extraPaths.prepend(path);
+        settings->generation.ref();
+    }
+    syncPluginPaths();
+}
+
+void GrantleeTemplateManager::syncPluginPaths()
+{
+    PluginPathSettings *const settings = sPluginPathSettings();
+    if (settings->generation.loadAcquire() == mPluginPathGeneration) {
+        return;
+    }
+
+    QStringList pluginPaths;
+    {
+        const QMutexLocker locker(&settings->mutex);
+        pluginPaths = settings->extraPaths;
+        mPluginPathGeneration = settings->generation.loadRelaxed();
+    }
+    pluginPaths.append(QStringLiteral(GRANTLEE_PLUGIN_INSTALL_DIR));
     mEngine->setPluginPaths(pluginPaths);
+
+    // Templates compiled so far may reference tags and filters from the old plugins
+    clearTemplateCache();
+}
+
+void GrantleeTemplateManager::clearTemplateCache()
+{
+    mTemplateCache.clear();
+    mCachingLoader->clear();
+}
+
+quint64 GrantleeTemplateManager::cacheHits() const
+{
+    return mCacheHits;
+}
+
+quint64 GrantleeTemplateManager::cacheMisses() const
+{
+    return mCacheMisses;
 }
+
 KTextTemplate::Context GrantleeTemplateManager::createContext(const QVariantHash &hash) const
 {
     KTextTemplate::Context ctx;
@@ -79,13 +139,33 @@ QString GrantleeTemplateManager::errorTemplate(const QString &reason, const QStr
     return tpl->render(&ctx);
 }
 
-QString GrantleeTemplateManager::render(const QString &templateName, const QVariantHash &data) const
+KTextTemplate::Template GrantleeTemplateManager::loadTemplate(const QString &templateName) const
 {
+    const auto it = mTemplateCache.constFind(templateName);
+    if (it != mTemplateCache.cend()) {
+        ++mCacheHits;
+        return *it;
+    }
+
+    ++mCacheMisses;
     if (!mLoader->canLoadTemplate(templateName)) {
         qWarning() << "Cannot load template" << templateName << ", please check your installation";
+        return KTextTemplate::Template();
+    }
+    KTextTemplate::Template const tpl = mCachingLoader->loadByName(templateName, mEngine);
+    if (!tpl->error()) {
+        // Do not cache broken templates, so that the error is reported every time
+        mTemplateCache.insert(templateName, tpl);
+    }
+    return tpl;
+}
+
+QString GrantleeTemplateManager::render(const QString &templateName, const QVariantHash &data) const
+{
+    KTextTemplate::Template const tpl = loadTemplate(templateName);
+    if (!tpl) {
         return QString();
     }
-    KTextTemplate::Template const tpl = mLoader->loadByName(templateName, mEngine);
     if (tpl->error()) {
         return errorTemplate(i18n("Template parsing error"), templateName, tpl);
     }
@@ -8,12 +8,14 @@
 #pragma once
 
 #include "kcalutils_private_export.h"
+#include <QHash>
 #include <QSharedPointer>
 #include <QVariantHash>
 
 namespace KTextTemplate
 {
 class Engine;
+class CachingLoaderDecorator;
 class FileSystemTemplateLoader;
 class TemplateImpl;
 class Context;
@@ -28,21 +30,49 @@ class KCALUTILS_TESTS_EXPORT GrantleeTemplateManager
 public:
     ~GrantleeTemplateManager();
 
+    /*
+     * Returns the template manager of the calling thread. KTextTemplate::Engine
+     * is not thread-safe, so every thread that formats incidences gets its own
+     * engine and template cache, which are destroyed when the thread exits.
+     */
     static GrantleeTemplateManager *instance();
 
+    /*
+     * Prepends @p path to the plugin search path of all template managers,
+     * including the ones of threads that already exist.
+     */
     void setPluginPath(const QString &path);
 
     [[nodiscard]] QString render(const QString &templateName, const QVariantHash &data) const;
 
+    /*
+     * Drops all compiled templates, the next render() will load and parse
+     * them again. Called automatically when the plugin path changes.
+     */
+    void clearTemplateCache();
+
+    [[nodiscard]] quint64 cacheHits() const;
+    [[nodiscard]] quint64 cacheMisses() const;
+
 private:
     Q_DISABLE_COPY(GrantleeTemplateManager)
     GrantleeTemplateManager();
     QString errorTemplate(const QString &reason, const QString &origTemplateName, const KTextTemplate::Template &failedTemplate) const;
     KTextTemplate::Context createContext(const QVariantHash &hash = QVariantHash()) const;
+    [[nodiscard]] KTextTemplate::Template loadTemplate(const QString &templateName) const;
+    void syncPluginPaths();
     KTextTemplate::Engine *const mEngine;
     QSharedPointer<KTextTemplate::FileSystemTemplateLoader> mLoader;
+    // Caches templates pulled in through {% extends %} and {% include %}
+    QSharedPointer<KTextTemplate::CachingLoaderDecorator> mCachingLoader;
 
     QSharedPointer<GrantleeKi18nLocalizer> mLocalizer;
 
-    static GrantleeTemplateManager *sInstance;
+    // Compiled top-level templates, keyed by template name
+    mutable QHash<QString, KTextTemplate::Template> mTemplateCache;
+    mutable quint64 mCacheHits = 0;
+    mutable quint64 mCacheMisses = 0;
+
+    // Generation of the shared plugin path list this engine was configured with
+    int mPluginPathGeneration = -1;
 };
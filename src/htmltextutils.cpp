@@ -0,0 +1,469 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "htmltextutils_p.h"
+
+#include <QList>
+#include <QStringTokenizer>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace KCalUtils;
+
+namespace
+{
+struct Entity {
+    const char *name;
+    char16_t code;
+};
+
+// The HTML 4 character entities, minus the Greek and mathematical symbols
+constexpr Entity sEntities[] = {
+    {"quot", 34}, {"amp", 38}, {"apos", 39}, {"lt", 60}, {"gt", 62}, {"nbsp", 160}, {"iexcl", 161}, {"cent", 162}, {"pound", 163}, {"curren", 164},
+    {"yen", 165}, {"brvbar", 166}, {"sect", 167}, {"uml", 168}, {"copy", 169}, {"ordf", 170}, {"laquo", 171}, {"not", 172}, {"shy", 173},
+    {"reg", 174}, {"macr", 175}, {"deg", 176}, {"plusmn", 177}, {"sup2", 178}, {"sup3", 179}, {"acute", 180}, {"micro", 181}, {"para", 182},
+    {"middot", 183}, {"cedil", 184}, {"sup1", 185}, {"ordm", 186}, {"raquo", 187}, {"frac14", 188}, {"frac12", 189}, {"frac34", 190},
+    {"iquest", 191}, {"Agrave", 192}, {"Aacute", 193}, {"Acirc", 194}, {"Atilde", 195}, {"Auml", 196}, {"Aring", 197}, {"AElig", 198},
+    {"Ccedil", 199}, {"Egrave", 200}, {"Eacute", 201}, {"Ecirc", 202}, {"Euml", 203}, {"Igrave", 204}, {"Iacute", 205}, {"Icirc", 206},
+    {"Iuml", 207}, {"ETH", 208}, {"Ntilde", 209}, {"Ograve", 210}, {"Oacute", 211}, {"Ocirc", 212}, {"Otilde", 213}, {"Ouml", 214}, {"times", 215},
+    {"Oslash", 216}, {"Ugrave", 217}, {"Uacute", 218}, {"Ucirc", 219}, {"Uuml", 220}, {"Yacute", 221}, {"THORN", 222}, {"szlig", 223},
+    {"agrave", 224}, {"aacute", 225}, {"acirc", 226}, {"atilde", 227}, {"auml", 228}, {"aring", 229}, {"aelig", 230}, {"ccedil", 231},
+    {"egrave", 232}, {"eacute", 233}, {"ecirc", 234}, {"euml", 235}, {"igrave", 236}, {"iacute", 237}, {"icirc", 238}, {"iuml", 239}, {"eth", 240},
+    {"ntilde", 241}, {"ograve", 242}, {"oacute", 243}, {"ocirc", 244}, {"otilde", 245}, {"ouml", 246}, {"divide", 247}, {"oslash", 248},
+    {"ugrave", 249}, {"uacute", 250}, {"ucirc", 251}, {"uuml", 252}, {"yacute", 253}, {"thorn", 254}, {"yuml", 255}, {"OElig", 338}, {"oelig", 339},
+    {"Scaron", 352}, {"scaron", 353}, {"Yuml", 376}, {"fnof", 402}, {"circ", 710}, {"tilde", 732}, {"ensp", 8194}, {"emsp", 8195}, {"thinsp", 8201},
+    {"zwnj", 8204}, {"zwj", 8205}, {"lrm", 8206}, {"rlm", 8207}, {"ndash", 8211}, {"mdash", 8212}, {"lsquo", 8216}, {"rsquo", 8217}, {"sbquo", 8218},
+    {"ldquo", 8220}, {"rdquo", 8221}, {"bdquo", 8222}, {"dagger", 8224}, {"Dagger", 8225}, {"bull", 8226}, {"hellip", 8230}, {"permil", 8240},
+    {"prime", 8242}, {"Prime", 8243}, {"lsaquo", 8249}, {"rsaquo", 8250}, {"euro", 8364}, {"trade", 8482},
+};
+
+// Elements starting and ending a block of text
+constexpr const char *sBlockElements[] = {
+    "address", "blockquote", "center", "dd",  "div", "dl", "dt", "h1",    "h2", "h3", "h4", "h5",
+    "h6",      "hr",         "li",     "ol",  "p",   "pre", "table", "td", "th", "tr", "ul",
+};
+
+// Elements that have neither content nor a closing tag
+constexpr const char *sVoidElements[] = {
+    "area", "base", "br", "col", "embed", "hr", "img", "input", "link", "meta", "param", "source", "track", "wbr",
+};
+
+// Elements whose content is not displayed
+constexpr const char *sHiddenElements[] = {"head", "script", "style", "title"};
+
+// Elements whose start tag ends the open elements listed in closes, as long as
+// none of the elements listed in scope is open above them. Lists are space separated
+struct ImpliedEnd {
+    const char *element;
+    const char *closes;
+    const char *scope;
+};
+
+constexpr ImpliedEnd sImpliedEnds[] = {
+    {"li", "li", "ul ol menu"},
+    {"dt", "dt dd", "dl"},
+    {"dd", "dt dd", "dl"},
+    {"td", "td th", "tr table"},
+    {"th", "td th", "tr table"},
+    {"tr", "tr td th", "thead tbody tfoot table"},
+    {"thead", "thead tbody tfoot tr td th", "table"},
+    {"tbody", "thead tbody tfoot tr td th", "table"},
+    {"tfoot", "thead tbody tfoot tr td th", "table"},
+    {"option", "option", "select datalist optgroup"},
+    {"optgroup", "optgroup option", "select"},
+};
+
+template<std::size_t N>
+bool contains(const char *const (&names)[N], QStringView name)
+{
+    return std::any_of(std::begin(names), std::end(names), [name](const char *candidate) {
+        return name.compare(QLatin1StringView(candidate), Qt::CaseInsensitive) == 0;
+    });
+}
+
+bool listContains(const char *names, QStringView name)
+{
+    for (const QLatin1StringView candidate : QLatin1StringView(names).tokenize(u' ')) {
+        if (name.compare(candidate, Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns how many of @p openElements are left open by the start tag of @p name,
+// which ends the elements whose end tag may be omitted
+qsizetype openElementsAfter(const QList<QStringView> &openElements, QStringView name)
+{
+    qsizetype remaining = openElements.size();
+
+    // A paragraph ends at the start of any block
+    if (contains(sBlockElements, name)) {
+        for (qsizetype i = openElements.size() - 1; i >= 0; --i) {
+            if (openElements.at(i).compare(QLatin1StringView("p"), Qt::CaseInsensitive) == 0) {
+                remaining = i;
+                break;
+            }
+            if (contains(sBlockElements, openElements.at(i))) {
+                break;
+            }
+        }
+    }
+
+    const auto rule = std::find_if(std::begin(sImpliedEnds), std::end(sImpliedEnds), [name](const ImpliedEnd &impliedEnd) {
+        return name.compare(QLatin1StringView(impliedEnd.element), Qt::CaseInsensitive) == 0;
+    });
+    if (rule != std::end(sImpliedEnds)) {
+        for (qsizetype i = remaining - 1; i >= 0; --i) {
+            if (listContains(rule->scope, openElements.at(i))) {
+                break;
+            }
+            if (listContains(rule->closes, openElements.at(i))) {
+                remaining = i;
+            }
+        }
+    }
+    return remaining;
+}
+
+bool isWhiteSpace(QChar c)
+{
+    return c == u' ' || c == u'\t' || c == u'\n' || c == u'\r' || c == u'\f';
+}
+
+class PlainTextWriter
+{
+public:
+    explicit PlainTextWriter(qsizetype reserveSize)
+    {
+        mText.reserve(reserveSize);
+    }
+
+    // Text as it appears in the document, whitespace runs collapse outside of <pre>
+    void appendText(QChar c)
+    {
+        if (mHiddenDepth > 0) {
+            return;
+        }
+        if (mPreDepth == 0 && isWhiteSpace(c)) {
+            if (!mAtLineStart && !mLastWasSpace) {
+                mText.append(u' ');
+                mLastWasSpace = true;
+            }
+            return;
+        }
+        if (c == u'\r') {
+            return;
+        }
+        flushBlockBreak();
+        if (c == QChar::Nbsp) {
+            c = u' ';
+        } else if (c == QChar::LineSeparator || c == QChar::ParagraphSeparator) {
+            c = u'\n';
+        }
+        mText.append(c);
+        mAtLineStart = c == u'\n';
+        mLastWasSpace = false;
+    }
+
+    // A character decoded from an entity, never collapsed
+    void appendEntity(QStringView text)
+    {
+        if (mHiddenDepth > 0) {
+            return;
+        }
+        flushBlockBreak();
+        for (QChar c : text) {
+            mText.append(c == QChar::Nbsp ? QChar(u' ') : c);
+        }
+        mAtLineStart = false;
+        mLastWasSpace = false;
+    }
+
+    void lineBreak()
+    {
+        if (mHiddenDepth > 0) {
+            return;
+        }
+        flushBlockBreak();
+        mText.append(u'\n');
+        mAtLineStart = true;
+        mLastWasSpace = false;
+    }
+
+    // Consecutive block boundaries give a single line break, none at the start or end
+    void blockBoundary()
+    {
+        if (mLastWasSpace) {
+            mText.chop(1);
+        }
+        mBlockBreak = true;
+        mAtLineStart = true;
+        mLastWasSpace = false;
+    }
+
+    void openElement(QStringView name)
+    {
+        if (contains(sHiddenElements, name)) {
+            ++mHiddenDepth;
+        } else if (name.compare(QLatin1StringView("pre"), Qt::CaseInsensitive) == 0) {
+            ++mPreDepth;
+        }
+    }
+
+    void closeElement(QStringView name)
+    {
+        if (contains(sHiddenElements, name)) {
+            mHiddenDepth = std::max(0, mHiddenDepth - 1);
+        } else if (name.compare(QLatin1StringView("pre"), Qt::CaseInsensitive) == 0) {
+            mPreDepth = std::max(0, mPreDepth - 1);
+        }
+    }
+
+    [[nodiscard]] QString take()
+    {
+        return std::move(mText);
+    }
+
+private:
+    void flushBlockBreak()
+    {
+        if (mBlockBreak && !mText.isEmpty()) {
+            mText.append(u'\n');
+        }
+        mBlockBreak = false;
+    }
+
+    QString mText;
+    int mHiddenDepth = 0;
+    int mPreDepth = 0;
+    bool mBlockBreak = false;
+    bool mAtLineStart = true;
+    bool mLastWasSpace = false;
+};
+
+// Decodes the entity starting at @p pos, just after the '&'. Returns its text and
+// moves @p pos after it, or returns an empty string if there is no known entity there.
+QString decodeEntity(QStringView html, qsizetype &pos)
+{
+    const qsizetype end = html.indexOf(u';', pos);
+    if (end < 0 || end == pos || end - pos > 10) {
+        return QString();
+    }
+    const QStringView name = html.sliced(pos, end - pos);
+
+    char32_t code = 0;
+    if (name.startsWith(u'#')) {
+        bool ok = false;
+        if (name.size() > 1 && (name.at(1) == u'x' || name.at(1) == u'X')) {
+            code = name.sliced(2).toUInt(&ok, 16);
+        } else {
+            code = name.sliced(1).toUInt(&ok, 10);
+        }
+        if (!ok || code == 0 || code > 0x10FFFF) {
+            return QString();
+        }
+    } else {
+        const auto it = std::find_if(std::begin(sEntities), std::end(sEntities), [name](const Entity &entity) {
+            return name == QLatin1StringView(entity.name);
+        });
+        if (it == std::end(sEntities)) {
+            return QString();
+        }
+        code = it->code;
+    }
+
+    pos = end + 1;
+    return QString::fromUcs4(&code, 1);
+}
+
+// Whether a tag, comment or declaration starts at @p pos, just after a '<'
+bool isTagStart(QStringView html, qsizetype pos)
+{
+    if (pos >= html.size()) {
+        return false;
+    }
+    const QChar c = html.at(pos);
+    return c.isLetter() || c == u'/' || c == u'!' || c == u'?';
+}
+
+struct Tag {
+    QStringView name; // empty for comments, doctype and processing instructions
+    bool closing = false;
+    bool selfClosing = false;
+};
+
+// Scans the tag starting at @p pos, just after the '<', and moves @p pos after it
+Tag scanTag(QStringView html, qsizetype &pos)
+{
+    if (html.sliced(pos).startsWith(QLatin1StringView("!--"))) {
+        const qsizetype end = html.indexOf(QLatin1StringView("-->"), pos + 3);
+        pos = end < 0 ? html.size() : end + 3;
+        return {};
+    }
+    if (html.at(pos) == u'!' || html.at(pos) == u'?') {
+        const qsizetype end = html.indexOf(u'>', pos);
+        pos = end < 0 ? html.size() : end + 1;
+        return {};
+    }
+
+    Tag tag;
+    tag.closing = html.at(pos) == u'/';
+    const qsizetype nameStart = tag.closing ? pos + 1 : pos;
+    qsizetype nameEnd = nameStart;
+    while (nameEnd < html.size() && html.at(nameEnd).isLetterOrNumber()) {
+        ++nameEnd;
+    }
+    tag.name = html.sliced(nameStart, nameEnd - nameStart);
+
+    // Skip the attributes, a '>' may appear in a quoted value
+    QChar quote;
+    qsizetype end = nameEnd;
+    for (; end < html.size(); ++end) {
+        const QChar c = html.at(end);
+        if (!quote.isNull()) {
+            if (c == quote) {
+                quote = QChar();
+            }
+        } else if (c == u'"' || c == u'\'') {
+            quote = c;
+        } else if (c == u'>') {
+            break;
+        }
+    }
+    pos = end < html.size() ? end + 1 : html.size();
+    tag.selfClosing = end > nameEnd && html.at(end - 1) == u'/';
+    return tag;
+}
+
+void applyTag(const Tag &tag, PlainTextWriter &writer)
+{
+    if (tag.name.isEmpty()) {
+        return;
+    }
+    if (tag.name.compare(QLatin1StringView("br"), Qt::CaseInsensitive) == 0) {
+        if (!tag.closing) {
+            writer.lineBreak();
+        }
+        return;
+    }
+    if (tag.name.compare(QLatin1StringView("img"), Qt::CaseInsensitive) == 0) {
+        if (!tag.closing) {
+            writer.appendEntity(QString(QChar::ObjectReplacementCharacter));
+        }
+        return;
+    }
+    if (contains(sBlockElements, tag.name)) {
+        writer.blockBoundary();
+    }
+    if (tag.closing) {
+        writer.closeElement(tag.name);
+    } else if (!tag.selfClosing) {
+        writer.openElement(tag.name);
+    }
+}
+}
+
+QString KCalUtils::htmlToPlainText(QStringView html)
+{
+    PlainTextWriter writer(html.size());
+
+    qsizetype pos = 0;
+    while (pos < html.size()) {
+        const QChar c = html.at(pos++);
+        if (c == u'<' && isTagStart(html, pos)) {
+            applyTag(scanTag(html, pos), writer);
+        } else if (c == u'&') {
+            const QString decoded = decodeEntity(html, pos);
+            if (decoded.isEmpty()) {
+                writer.appendText(c);
+            } else {
+                writer.appendEntity(decoded);
+            }
+        } else {
+            writer.appendText(c);
+        }
+    }
+    return writer.take();
+}
+
+QString KCalUtils::truncateRichText(QStringView html, qsizetype maxLength, QStringView ellipsis)
+{
+    QList<QStringView> openElements;
+    int hiddenDepth = 0;
+    qsizetype length = 0;
+    bool lastWasSpace = true;
+
+    qsizetype pos = 0;
+    while (pos < html.size()) {
+        const qsizetype start = pos;
+        const QChar c = html.at(pos++);
+        if (c == u'<' && isTagStart(html, pos)) {
+            const Tag tag = scanTag(html, pos);
+            if (tag.name.isEmpty() || contains(sVoidElements, tag.name)) {
+                continue;
+            }
+            if (contains(sBlockElements, tag.name)) {
+                lastWasSpace = true;
+            }
+            const auto closeFrom = [&openElements, &hiddenDepth](qsizetype index) {
+                for (qsizetype i = index; i < openElements.size(); ++i) {
+                    hiddenDepth -= contains(sHiddenElements, openElements.at(i)) ? 1 : 0;
+                }
+                openElements.resize(index);
+            };
+            if (tag.closing) {
+                // Elements left open in between were closed implicitly
+                for (qsizetype i = openElements.size() - 1; i >= 0; --i) {
+                    if (openElements.at(i).compare(tag.name, Qt::CaseInsensitive) == 0) {
+                        closeFrom(i);
+                        break;
+                    }
+                }
+            } else {
+                // As are the siblings whose end tag was omitted, e.g. list items
+                closeFrom(openElementsAfter(openElements, tag.name));
+                if (!tag.selfClosing) {
+                    openElements.append(tag.name);
+                    hiddenDepth += contains(sHiddenElements, tag.name) ? 1 : 0;
+                }
+            }
+            continue;
+        }
+
+        // An entity or a surrogate pair is a single visible character
+        if (c == u'&') {
+            decodeEntity(html, pos);
+        } else if (c.isHighSurrogate() && pos < html.size() && html.at(pos).isLowSurrogate()) {
+            ++pos;
+        }
+        if (hiddenDepth > 0) {
+            continue;
+        }
+        const bool space = isWhiteSpace(c);
+        if (space && lastWasSpace) {
+            continue;
+        }
+        if (length == maxLength) {
+            QString truncated;
+            truncated.reserve(start + ellipsis.size() + openElements.size() * 8);
+            truncated.append(html.first(start));
+            truncated.append(ellipsis);
+            for (auto it = openElements.crbegin(); it != openElements.crend(); ++it) {
+                truncated.append(QLatin1StringView("</"));
+                truncated.append(*it);
+                truncated.append(u'>');
+            }
+            return truncated;
+        }
+        ++length;
+        lastWasSpace = space;
+    }
+    return html.toString();
+}
@@ -0,0 +1,41 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kcalutils_private_export.h"
+
+#include <QString>
+#include <QStringView>
+
+namespace KCalUtils
+{
+/*
+ * Converts the rich text @p html to plain text the way
+ * QTextDocumentFragment::fromHtml(html).toPlainText() does, but in a single
+ * pass over the markup without building or laying out a document.
+ *
+ * Tags are stripped, whitespace collapses outside of <pre>, <br> and block
+ * elements such as <p>, <div> or <li> become line breaks, the content of
+ * <head>, <style>, <script> and <title> is dropped and the HTML 4 Latin-1,
+ * special and punctuation entities as well as numeric references are
+ * decoded. Unknown entities are kept as they are.
+ */
+[[nodiscard]] KCALUTILS_TESTS_EXPORT QString htmlToPlainText(QStringView html);
+
+/*
+ * Returns the rich text @p html cut after its first @p maxLength visible
+ * characters, followed by @p ellipsis and the closing tags of the elements
+ * still open at that point. Markup is not counted, entities count as one
+ * character and whitespace runs as one space.
+ *
+ * The markup is scanned once and only up to the cut, without parsing it
+ * into a document. If there is nothing to cut @p html is returned unchanged.
+ */
+[[nodiscard]] KCALUTILS_TESTS_EXPORT QString truncateRichText(QStringView html, qsizetype maxLength, QStringView ellipsis);
+}
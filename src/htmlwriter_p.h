@@ -0,0 +1,174 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+namespace KCalUtils
+{
+/*
+ * Appends HTML fragments to a single pre-sized buffer, so that building a
+ * tooltip does not create a temporary QString for every `a + b` chain.
+ *
+ * A writer in plain text mode writes the same structure without any markup:
+ * line breaks and rules become newlines and labels lose their emphasis.
+ * Callers check richText() before writing fragments of their own.
+ */
+class HtmlWriter
+{
+public:
+    explicit HtmlWriter(qsizetype reserveSize = 1024, bool richText = true)
+        : mRichText(richText)
+    {
+        mBuffer.reserve(reserveSize);
+    }
+
+    [[nodiscard]] bool richText() const
+    {
+        return mRichText;
+    }
+
+    HtmlWriter &operator<<(QStringView text)
+    {
+        mBuffer.append(text);
+        return *this;
+    }
+
+    HtmlWriter &operator<<(QLatin1StringView text)
+    {
+        mBuffer.append(text);
+        return *this;
+    }
+
+    HtmlWriter &operator<<(const QString &text)
+    {
+        mBuffer.append(text);
+        return *this;
+    }
+
+    HtmlWriter &operator<<(QChar c)
+    {
+        mBuffer.append(c);
+        return *this;
+    }
+
+    // Writes "<i>label</i>" followed by a space, or by a line break if @p ownLine
+    void label(QStringView label, bool ownLine = false)
+    {
+        if (!mRichText) {
+            *this << label << (ownLine ? u'\n' : u' ');
+            return;
+        }
+        *this << QLatin1StringView("<i>") << label << QLatin1StringView("</i>");
+        if (ownLine) {
+            lineBreak();
+        } else {
+            *this << QLatin1StringView("&nbsp;");
+        }
+    }
+
+    // Writes a translated "<i>Label:</i> value" string, where the value is already
+    // substituted: with non-breaking spaces in HTML, without the emphasis in plain text
+    void field(QStringView text)
+    {
+        qsizetype from = 0;
+        if (mRichText) {
+            for (qsizetype space = text.indexOf(u' '); space >= 0; space = text.indexOf(u' ', from)) {
+                mBuffer.append(text.sliced(from, space - from));
+                mBuffer.append(QLatin1StringView("&nbsp;"));
+                from = space + 1;
+            }
+        } else {
+            for (qsizetype tag = text.indexOf(u'<'); tag >= 0; tag = text.indexOf(u'<', from)) {
+                const QStringView rest = text.sliced(tag);
+                const qsizetype tagSize = rest.startsWith(QLatin1StringView("<i>")) ? 3 : rest.startsWith(QLatin1StringView("</i>")) ? 4 : 0;
+                if (tagSize == 0) {
+                    mBuffer.append(text.sliced(from, tag + 1 - from));
+                    from = tag + 1;
+                    continue;
+                }
+                mBuffer.append(text.sliced(from, tag - from));
+                from = tag + tagSize;
+            }
+        }
+        mBuffer.append(text.sliced(from));
+    }
+
+    void lineBreak()
+    {
+        if (mRichText) {
+            mBuffer.append(QLatin1StringView("<br>"));
+        } else {
+            mBuffer.append(u'\n');
+        }
+    }
+
+    void rule()
+    {
+        if (mRichText) {
+            mBuffer.append(QLatin1StringView("<hr>"));
+        } else {
+            mBuffer.append(u'\n');
+        }
+    }
+
+    // Two non-breaking spaces, indenting the entries of a list
+    void indent()
+    {
+        if (mRichText) {
+            mBuffer.append(QLatin1StringView("&nbsp;&nbsp;"));
+        } else {
+            mBuffer.append(QLatin1StringView("  "));
+        }
+    }
+
+    [[nodiscard]] qsizetype size() const
+    {
+        return mBuffer.size();
+    }
+
+    [[nodiscard]] bool endsWith(QLatin1StringView text) const
+    {
+        return mBuffer.endsWith(text);
+    }
+
+    // Drops the line break written last, if any
+    void chopLineBreak()
+    {
+        if (mRichText) {
+            if (mBuffer.endsWith(QLatin1StringView("<br>"))) {
+                mBuffer.chop(4);
+            }
+        } else if (mBuffer.endsWith(u'\n')) {
+            mBuffer.chop(1);
+        }
+    }
+
+    // Drops everything written after position @p size, e.g. a heading of an empty section
+    void truncate(qsizetype size)
+    {
+        mBuffer.truncate(size);
+    }
+
+    void chop(qsizetype n)
+    {
+        mBuffer.chop(n);
+    }
+
+    [[nodiscard]] QString take()
+    {
+        return std::move(mBuffer);
+    }
+
+private:
+    QString mBuffer;
+    const bool mRichText;
+};
+}
@@ -49,12 +49,11 @@ bool ICalDrag::fromMimeData(const QMimeData *de, const Calendar::Ptr &cal)
     }
     bool success = false;
 
-    QByteArray payload = de->data(mimeType());
+    const QByteArray payload = de->data(mimeType());
     if (!payload.isEmpty()) {
-        QString const txt = QString::fromUtf8(payload.data());
-
+        // Hand the UTF-8 payload to the parser as is, without a round trip through QString
         ICalFormat icf;
-        success = icf.fromString(cal, txt);
+        success = icf.fromRawString(cal, payload);
     }
 
     return success;
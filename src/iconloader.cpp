@@ -0,0 +1,27 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "iconloader_p.h"
+
+#include <KIconLoader>
+
+#include <QMutex>
+
+Q_GLOBAL_STATIC(QMutex, sIconLoaderMutex)
+
+QString KCalUtils::iconPath(const QString &iconName, int groupOrSize, bool canReturnNull)
+{
+    const QMutexLocker locker(sIconLoaderMutex());
+    return KIconLoader::global()->iconPath(iconName, groupOrSize, canReturnNull);
+}
+
+int KCalUtils::iconCurrentSize(int group)
+{
+    const QMutexLocker locker(sIconLoaderMutex());
+    return KIconLoader::global()->currentSize(static_cast<KIconLoader::Group>(group));
+}
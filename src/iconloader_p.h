@@ -0,0 +1,25 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kcalutils_export.h"
+
+#include <QString>
+
+namespace KCalUtils
+{
+/*
+ * KIconLoader is not thread-safe. The formatters and the {% icon %} template
+ * tag resolve icons through these wrappers, which serialize the access to
+ * KIconLoader::global(), so that incidences can be formatted from worker threads.
+ * They are exported for the template plugin, which must share the same lock.
+ */
+[[nodiscard]] KCALUTILS_EXPORT QString iconPath(const QString &iconName, int groupOrSize, bool canReturnNull = false);
+[[nodiscard]] KCALUTILS_EXPORT int iconCurrentSize(int group);
+}
@@ -21,9 +21,17 @@
   @author Allen Winter \<allen@kdab.com\>
 */
 #include "incidenceformatter.h"
+#include "eventconflictindex_p.h"
+#include "formatterlabels_p.h"
 #include "grantleetemplatemanager_p.h"
+#include "htmltextutils_p.h"
+#include "htmlwriter_p.h"
+#include "iconloader_p.h"
+#include "incidencelookupindex_p.h"
+#include "occurrencecache_p.h"
 #include "stringify.h"
 
+#include <KCalendarCore/CalFilter>
 #include <KCalendarCore/Event>
 #include <KCalendarCore/FreeBusy>
 #include <KCalendarCore/ICalFormat>
@@ -43,10 +51,20 @@ using namespace KCalendarCore;
 
 #include <QApplication>
 #include <QBitArray>
+#include <QCache>
 #include <QLocale>
 #include <QMimeDatabase>
+#include <QMutex>
 #include <QPalette>
-#include <QTextDocumentFragment>
+#include <QPromise>
+#include <QSet>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 
 using namespace KCalUtils;
 using namespace IncidenceFormatter;
@@ -55,12 +73,47 @@ using namespace IncidenceFormatter;
  *  General helpers
  *******************/
 
-static QVariantHash inviteButton(const QString &id, const QString &text, const QString &iconName, InvitationFormatterHelper *helper);
+// The links of the invitation buttons. Asynchronous renders resolve all of them up front
+enum class InvitationLink : quint8 {
+    None,
+    Record,
+    Delete,
+    Accept,
+    AcceptConditionally,
+    Decline,
+    Counter,
+    Delegate,
+    AcceptCounter,
+    DeclineCounter,
+    Reply,
+    Cancel,
+    CheckCalendar,
+};
+
+// The ids passed to InvitationFormatterHelper::generateLinkURL(), indexed by InvitationLink
+constexpr const char *sInvitationLinkIds[] = {
+    nullptr,
+    "record",
+    "delete",
+    "accept",
+    "accept_conditionally",
+    "decline",
+    "counter",
+    "delegate",
+    "accept_counter",
+    "decline_counter",
+    "reply",
+    "cancel",
+    "check_calendar",
+};
+static_assert(std::size(sInvitationLinkIds) == static_cast<std::size_t>(InvitationLink::CheckCalendar) + 1);
+
+static QVariantHash inviteButton(InvitationLink link, const QString &text, const QString &iconName, InvitationFormatterHelper *helper);
 
 //@cond PRIVATE
 static QString cleanHtml(const QString &html)
 {
-    return QTextDocumentFragment::fromHtml(html).toPlainText();
+    return htmlToPlainText(html);
 }
 
 [[nodiscard]] static QString string2HTML(const QString &str)
@@ -71,6 +124,9 @@ static QString cleanHtml(const QString &html)
 
 [[nodiscard]] static bool thatIsMe(const QString &email)
 {
+    // The identity manager is a plain global, serialize access for the concurrent formatters
+    static QMutex mutex;
+    const QMutexLocker locker(&mutex);
     return KIdentityManagementCore::thatIsMe(email);
 }
 
@@ -170,6 +226,63 @@ struct IncidenceNameAndUid {
     }
 }
 
+namespace
+{
+// The attendees of an incidence, sorted by role in a single pass over them
+class AttendeeClassifier
+{
+public:
+    explicit AttendeeClassifier(const Incidence::Ptr &incidence)
+        : mAttendees(incidence->attendees())
+        , mIsOrganizer(mAttendees.size())
+    {
+        const QString organizerEmail = incidence->organizer().email();
+        for (qsizetype i = 0; i < mAttendees.size(); ++i) {
+            const Attendee &a = mAttendees.at(i);
+            if (!a.isNull() && a.email() == organizerEmail) {
+                mIsOrganizer.setBit(i);
+                continue;
+            }
+            const auto role = static_cast<std::size_t>(a.role());
+            if (role < mRoles.size()) {
+                mRoles[role].append(a);
+            }
+        }
+    }
+
+    // All the attendees, the organizer included
+    [[nodiscard]] const Attendee::List &attendees() const
+    {
+        return mAttendees;
+    }
+
+    [[nodiscard]] bool isOrganizer(qsizetype index) const
+    {
+        return mIsOrganizer.testBit(index);
+    }
+
+    // The attendees with @p role, except the organizer
+    [[nodiscard]] const Attendee::List &withRole(Attendee::Role role) const
+    {
+        static const Attendee::List none;
+        const auto index = static_cast<std::size_t>(role);
+        return index < mRoles.size() ? mRoles[index] : none;
+    }
+
+    // The organizer is only worth showing if someone else attends
+    [[nodiscard]] bool showOrganizer() const
+    {
+        return mAttendees.size() > 1 || (mAttendees.size() == 1 && !isOrganizer(0));
+    }
+
+private:
+    Attendee::List mAttendees;
+    QBitArray mIsOrganizer;
+    // Indexed by Attendee::Role
+    std::array<Attendee::List, 4> mRoles;
+};
+}
+
 [[nodiscard]] static QString organizerName(const Incidence::Ptr &incidence, const QString &defName)
 {
     QString tName;
@@ -306,21 +419,12 @@ struct IncidenceNameAndUid {
     return QString();
 }
 
-[[nodiscard]] static QVariantList displayViewFormatAttendeeRoleList(const Incidence::Ptr &incidence, Attendee::Role role, bool showStatus)
+[[nodiscard]] static QVariantList displayViewFormatAttendeeRoleList(const AttendeeClassifier &attendees, Attendee::Role role, bool showStatus)
 {
     QVariantList attendeeDataList;
-    attendeeDataList.reserve(incidence->attendeeCount());
+    attendeeDataList.reserve(attendees.withRole(role).size());
 
-    const Attendee::List attendees = incidence->attendees();
-    for (const auto &a : attendees) {
-        if (a.role() != role) {
-            // skip this role
-            continue;
-        }
-        if (attendeeIsOrganizer(incidence, a)) {
-            // skip attendee that is also the organizer
-            continue;
-        }
+    for (const auto &a : attendees.withRole(role)) {
         QVariantHash attendeeData = displayViewFormatPerson(a.email(), a.name(), a.uid(), showStatus ? a.status() : Attendee::None);
         if (!a.delegator().isEmpty()) {
             attendeeData[QStringLiteral("delegator")] = a.delegator();
@@ -338,11 +442,10 @@ struct IncidenceNameAndUid {
     return attendeeDataList;
 }
 
-[[nodiscard]] static QVariantHash displayViewFormatOrganizer(const Incidence::Ptr &incidence)
+[[nodiscard]] static QVariantHash displayViewFormatOrganizer(const Incidence::Ptr &incidence, const AttendeeClassifier &attendees)
 {
     // Add organizer link
-    const int attendeeCount = incidence->attendees().count();
-    if (attendeeCount > 1 || (attendeeCount == 1 && !attendeeIsOrganizer(incidence, incidence->attendees().at(0)))) {
+    if (attendees.showOrganizer()) {
         const IncidenceNameAndUid s = searchNameAndUid(incidence->organizer().email(), incidence->organizer().name(), QString());
         return displayViewFormatPerson(incidence->organizer().email(), s.name, s.uid, QStringLiteral("meeting-organizer"));
     }
@@ -381,6 +484,18 @@ struct IncidenceNameAndUid {
     return dataList;
 }
 
+// Fills the data of the attendees.html section of the event and to-do views
+static void displayViewFormatAttendees(const Calendar::Ptr &calendar, const Incidence::Ptr &incidence, QVariantHash &incidenceData)
+{
+    const AttendeeClassifier attendees(incidence);
+    incidenceData[QStringLiteral("organizer")] = displayViewFormatOrganizer(incidence, attendees);
+    const bool showStatus = incOrganizerOwnsCalendar(calendar, incidence);
+    incidenceData[QStringLiteral("chair")] = displayViewFormatAttendeeRoleList(attendees, Attendee::Chair, showStatus);
+    incidenceData[QStringLiteral("requiredParticipants")] = displayViewFormatAttendeeRoleList(attendees, Attendee::ReqParticipant, showStatus);
+    incidenceData[QStringLiteral("optionalParticipants")] = displayViewFormatAttendeeRoleList(attendees, Attendee::OptParticipant, showStatus);
+    incidenceData[QStringLiteral("observers")] = displayViewFormatAttendeeRoleList(attendees, Attendee::NonParticipant, showStatus);
+}
+
 [[nodiscard]] static QVariantHash displayViewFormatBirthday(const Event::Ptr &event)
 {
     if (!event) {
@@ -447,7 +562,7 @@ struct IncidenceNameAndUid {
         incidence[QStringLiteral("location")] = richLocation;
     }
 
-    const auto startDts = event->startDateTimesForDate(date, QTimeZone::systemTimeZone());
+    const auto startDts = OccurrenceCache::startDateTimesForDate(event, date, QTimeZone::systemTimeZone());
     QDateTime startDt;
     QDateTime endDt;
     if (startDts.isEmpty()) {
@@ -491,12 +606,7 @@ struct IncidenceNameAndUid {
         remVars.append(rem);
     }
     incidence[QStringLiteral("reminders")] = remVars;
-    incidence[QStringLiteral("organizer")] = displayViewFormatOrganizer(event);
-    const bool showStatus = incOrganizerOwnsCalendar(calendar, event);
-    incidence[QStringLiteral("chair")] = displayViewFormatAttendeeRoleList(event, Attendee::Chair, showStatus);
-    incidence[QStringLiteral("requiredParticipants")] = displayViewFormatAttendeeRoleList(event, Attendee::ReqParticipant, showStatus);
-    incidence[QStringLiteral("optionalParticipants")] = displayViewFormatAttendeeRoleList(event, Attendee::OptParticipant, showStatus);
-    incidence[QStringLiteral("observers")] = displayViewFormatAttendeeRoleList(event, Attendee::NonParticipant, showStatus);
+    displayViewFormatAttendees(calendar, event, incidence);
 
     QVariantList catVars;
     const QStringList catList = event->categories();
@@ -554,7 +664,7 @@ struct IncidenceNameAndUid {
             if (ocurrenceDueDate.isValid()) {
                 QDateTime kdt(ocurrenceDueDate, QTime(0, 0, 0), QTimeZone::LocalTime);
                 kdt = kdt.addSecs(-1);
-                dueDt.setDate(todo->recurrence()->getNextDateTime(kdt).date());
+                dueDt.setDate(OccurrenceCache::nextDateTime(todo, kdt).date());
             }
         }
         incidence[QStringLiteral("dueDate")] = dueDt;
@@ -577,12 +687,7 @@ struct IncidenceNameAndUid {
     }
     incidence[QStringLiteral("reminders")] = remVars;
 
-    incidence[QStringLiteral("organizer")] = displayViewFormatOrganizer(todo);
-    const bool showStatus = incOrganizerOwnsCalendar(calendar, todo);
-    incidence[QStringLiteral("chair")] = displayViewFormatAttendeeRoleList(todo, Attendee::Chair, showStatus);
-    incidence[QStringLiteral("requiredParticipants")] = displayViewFormatAttendeeRoleList(todo, Attendee::ReqParticipant, showStatus);
-    incidence[QStringLiteral("optionalParticipants")] = displayViewFormatAttendeeRoleList(todo, Attendee::OptParticipant, showStatus);
-    incidence[QStringLiteral("observers")] = displayViewFormatAttendeeRoleList(todo, Attendee::NonParticipant, showStatus);
+    displayViewFormatAttendees(calendar, todo, incidence);
 
     QVariantList catVars;
     const QStringList catList = todo->categories();
@@ -782,6 +887,45 @@ QString IncidenceFormatter::extensiveDisplayStr(const QString &sourceName, const
     }
 }
 
+QString IncidenceFormatter::extensiveDisplaySection(const Calendar::Ptr &calendar, const IncidenceBase::Ptr &incidence, DisplaySection section)
+{
+    if (!incidence || (incidence->type() != IncidenceBase::TypeEvent && incidence->type() != IncidenceBase::TypeTodo)) {
+        return QString();
+    }
+    const Incidence::Ptr inc = incidence.staticCast<Incidence>();
+
+    switch (section) {
+    case AttendeesSection: {
+        QVariantHash incidenceData;
+        displayViewFormatAttendees(calendar, inc, incidenceData);
+        return GrantleeTemplateManager::instance()->render(QStringLiteral("org.kde.pim/kcalutils/attendees.html"), incidenceData);
+    }
+    }
+    return QString();
+}
+
+QStringList
+IncidenceFormatter::extensiveDisplayStrs(const Calendar::Ptr &calendar, const Incidence::List &incidences, QDate date, QThreadPool *pool)
+{
+    const auto format = [&calendar, date](const Incidence::Ptr &incidence) {
+        return extensiveDisplayStr(calendar, incidence, date);
+    };
+
+    if (incidences.size() < 2) {
+        QStringList results;
+        for (const Incidence::Ptr &incidence : incidences) {
+            results.append(format(incidence));
+        }
+        return results;
+    }
+
+    // Create the identity manager in the calling thread before the workers need it.
+    // Each worker keeps its template manager, with its compiled templates, across calls.
+    (void)thatIsMe(QString());
+
+    return QtConcurrent::blockingMapped(pool ? pool : QThreadPool::globalInstance(), incidences, format);
+}
+
 /***********************************************************************
  *  Helper functions for the body part formatter of kmail (Invitations)
  ***********************************************************************/
@@ -999,16 +1143,68 @@ static QString invitationLocation(const Incidence::Ptr &incidence, bool noHtmlMo
     return QString();
 }
 
+class KCalUtils::InvitationFormatterHelperPrivate
+{
+public:
+    static InvitationFormatterHelperPrivate *get(InvitationFormatterHelper *q)
+    {
+        return q->d.get();
+    }
+
+    // Returns the index of @p calendar, binding it on first use and
+    // rebinding it when the helper calendar changed
+    const IncidenceLookupIndex *lookupIndex(const Calendar::Ptr &calendar)
+    {
+        return bind(mLookupIndex, calendar);
+    }
+
+    // Same for the index of the events of @p calendar by time span
+    const EventConflictIndex *conflictIndex(const Calendar::Ptr &calendar)
+    {
+        return bind(mConflictIndex, calendar);
+    }
+
+    // Binds the indexes of @p other to @p calendar and uses them from now on.
+    // Shared indexes are never rebound from here, which lets the worker of an
+    // asynchronous render use them while @p other binds new ones
+    void share(InvitationFormatterHelperPrivate *other, const Calendar::Ptr &calendar)
+    {
+        (void)other->lookupIndex(calendar);
+        (void)other->conflictIndex(calendar);
+        mLookupIndex = other->mLookupIndex;
+        mConflictIndex = other->mConflictIndex;
+        mShared = true;
+    }
+
+private:
+    template<typename Index>
+    const Index *bind(std::shared_ptr<Index> &index, const Calendar::Ptr &calendar)
+    {
+        if (!mShared && !index->isAttachedTo(calendar)) {
+            // Another helper may still read the old calendar from it
+            if (index.use_count() > 1) {
+                index = std::make_shared<Index>();
+            }
+            index->attach(calendar);
+        }
+        return index.get();
+    }
+
+    std::shared_ptr<IncidenceLookupIndex> mLookupIndex = std::make_shared<IncidenceLookupIndex>();
+    std::shared_ptr<EventConflictIndex> mConflictIndex = std::make_shared<EventConflictIndex>();
+    bool mShared = false;
+};
+
 [[nodiscard]] static bool slicesInterval(const Event::Ptr &event, const QDateTime &startDt, const QDateTime &endDt)
 {
     QDateTime closestStart = event->dtStart();
     QDateTime closestEnd = event->dtEnd();
     if (event->recurs()) {
-        if (!event->recurrence()->timesInInterval(startDt, endDt).isEmpty()) {
+        if (!OccurrenceCache::timesInInterval(event, startDt, endDt).isEmpty()) {
             // If there is a recurrence in this interval we know already that we slice.
             return true;
         }
-        closestStart = event->recurrence()->getPreviousDateTime(startDt);
+        closestStart = OccurrenceCache::previousDateTime(event, startDt);
         if (event->hasEndDate()) {
             closestEnd = closestStart.addSecs(event->dtStart().secsTo(event->dtEnd()));
         }
@@ -1034,7 +1230,7 @@ static QString invitationLocation(const Incidence::Ptr &incidence, bool noHtmlMo
     return (closestStart >= startDt && closestStart <= endDt) && (closestEnd >= startDt && closestEnd <= endDt);
 }
 
-[[nodiscard]] static QVariantList eventsOnSameDays(const InvitationFormatterHelper *helper, const Event::Ptr &event, bool noHtmlMode)
+[[nodiscard]] static QVariantList eventsOnSameDays(InvitationFormatterHelper *helper, const Event::Ptr &event, bool noHtmlMode)
 {
     if (!event || !helper || !helper->calendar()) {
         return QVariantList();
@@ -1045,7 +1241,17 @@ static QString invitationLocation(const Incidence::Ptr &incidence, bool noHtmlMo
     startDay.setTime(QTime(0, 0, 0));
     endDay.setTime(QTime(23, 59, 59));
 
-    Event::List const matchingEvents = helper->calendar()->events(startDay.date(), endDay.date(), QTimeZone::systemTimeZone());
+    // Look at the same days as Calendar::events() would, taken in the system time zone,
+    // whatever the time zones of the invitation and of the events of the calendar
+    const QDateTime firstDay(startDay.date(), QTime(0, 0, 0), QTimeZone::systemTimeZone());
+    const QDateTime lastDay(endDay.date(), QTime(23, 59, 59, 999), QTimeZone::systemTimeZone());
+
+    const Calendar::Ptr calendar = helper->calendar();
+    const EventConflictIndex *conflictIndex = InvitationFormatterHelperPrivate::get(helper)->conflictIndex(calendar);
+    Event::List matchingEvents = conflictIndex->overlapping(firstDay, lastDay);
+    if (CalFilter *filter = calendar->filter()) {
+        filter->apply(&matchingEvents);
+    }
     if (matchingEvents.isEmpty()) {
         return QVariantList();
     }
@@ -1058,11 +1264,10 @@ static QString invitationLocation(const Incidence::Ptr &incidence, bool noHtmlMo
             continue;
         }
         if (!slicesInterval(*it, startDay, endDay)) {
-            /* Calendar::events includes events that have a recurrence that is
-             * "active" in the specified interval. Whether or not the event is actually
-             * happening ( has a recurrence that falls into the interval ).
-             * This appears to be done deliberately and not to be a bug so we additionally
-             * check if the event is actually happening here. */
+            /* The index returns recurring events whose recurrence is "active"
+             * in the specified interval, whether or not one of their occurrences
+             * falls into it. So we additionally check if the event is actually
+             * happening here. */
             continue;
         }
         ++count;
@@ -1098,7 +1303,7 @@ static QString invitationLocation(const Incidence::Ptr &incidence, bool noHtmlMo
     incidence[QStringLiteral("description")] = invitationDescriptionIncidence(event, noHtmlMode);
 
     incidence[QStringLiteral("checkCalendarButton")] =
-        inviteButton(QStringLiteral("check_calendar"), i18n("Check my calendar"), QStringLiteral("go-jump-today"), helper);
+        inviteButton(InvitationLink::CheckCalendar, i18n("Check my calendar"), QStringLiteral("go-jump-today"), helper);
     incidence[QStringLiteral("eventsOnSameDays")] = eventsOnSameDays(helper, event, noHtmlMode);
 
     return incidence;
@@ -1158,7 +1363,7 @@ QString IncidenceFormatter::formatStartEnd(const QDateTime &start, const QDateTi
     incidence[QStringLiteral("description")] = invitationDescriptionIncidence(event, noHtmlMode);
 
     incidence[QStringLiteral("checkCalendarButton")] =
-        inviteButton(QStringLiteral("check_calendar"), i18n("Check my calendar"), QStringLiteral("go-jump-today"), helper);
+        inviteButton(InvitationLink::CheckCalendar, i18n("Check my calendar"), QStringLiteral("go-jump-today"), helper);
     incidence[QStringLiteral("eventsOnSameDays")] = eventsOnSameDays(helper, event, noHtmlMode);
 
     return incidence;
@@ -1338,9 +1543,11 @@ invitationHeaderEvent(const Event::Ptr &event, const Incidence::Ptr &existingInc
         return QString();
     }
 
+    const std::shared_ptr<const FormatterLabels> labels = FormatterLabels::get();
+
     switch (msg->method()) {
     case iTIPPublish:
-        return i18n("This invitation has been published.");
+        return labels->eventPublished;
     case iTIPRequest:
         if (existingIncidence && event->revision() > 0) {
             QString const orgStr = organizerName(event, sender);
@@ -1351,7 +1558,7 @@ invitationHeaderEvent(const Event::Ptr &event, const Incidence::Ptr &existingInc
             }
         }
         if (iamOrganizer(event)) {
-            return i18n("I created this invitation.");
+            return labels->eventCreatedByMe;
         } else {
             QString const orgStr = organizerName(event, sender);
             if (senderIsOrganizer(event, sender)) {
@@ -1361,15 +1568,15 @@ invitationHeaderEvent(const Event::Ptr &event, const Incidence::Ptr &existingInc
             }
         }
     case iTIPRefresh:
-        return i18n("This invitation was refreshed.");
+        return labels->eventRefreshed;
     case iTIPCancel:
         if (iamOrganizer(event)) {
-            return i18n("This invitation has been canceled.");
+            return labels->eventCanceled;
         } else {
-            return i18n("The organizer has revoked the invitation.");
+            return labels->eventRevoked;
         }
     case iTIPAdd:
-        return i18n("Addition to the invitation.");
+        return labels->eventAddition;
     case iTIPReply: {
         /* cppcheck-suppress knownConditionTrueFalse */
         if (replyMeansCounter(event)) {
@@ -1438,11 +1645,11 @@ invitationHeaderEvent(const Event::Ptr &event, const Incidence::Ptr &existingInc
             }
         }
         case Attendee::Completed:
-            return i18n("This invitation is now completed.");
+            return labels->eventCompleted;
         case Attendee::InProcess:
             return i18n("%1 is still processing the invitation.", attendeeName);
         case Attendee::None:
-            return i18n("Unknown response to this invitation.");
+            return labels->eventUnknownResponse;
         }
         break;
     }
@@ -1472,9 +1679,11 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
         return QString();
     }
 
+    const std::shared_ptr<const FormatterLabels> labels = FormatterLabels::get();
+
     switch (msg->method()) {
     case iTIPPublish:
-        return i18n("This to-do has been published.");
+        return labels->todoPublished;
     case iTIPRequest:
         if (existingIncidence && todo->revision() > 0) {
             QString const orgStr = organizerName(todo, sender);
@@ -1485,7 +1694,7 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
             }
         } else {
             if (iamOrganizer(todo)) {
-                return i18n("I created this to-do.");
+                return labels->todoCreatedByMe;
             } else {
                 QString const orgStr = organizerName(todo, sender);
                 if (senderIsOrganizer(todo, sender)) {
@@ -1496,15 +1705,15 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
             }
         }
     case iTIPRefresh:
-        return i18n("This to-do was refreshed.");
+        return labels->todoRefreshed;
     case iTIPCancel:
         if (iamOrganizer(todo)) {
-            return i18n("This to-do was canceled.");
+            return labels->todoCanceled;
         } else {
-            return i18n("The organizer has revoked this to-do.");
+            return labels->todoRevoked;
         }
     case iTIPAdd:
-        return i18n("Addition to the to-do.");
+        return labels->todoAddition;
     case iTIPReply: {
         /* cppcheck-suppress knownConditionTrueFalse */
         if (replyMeansCounter(todo)) {
@@ -1581,11 +1790,11 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
             }
         }
         case Attendee::Completed:
-            return i18n("The request for this to-do is now completed.");
+            return labels->todoCompleted;
         case Attendee::InProcess:
             return i18n("%1 is still processing the to-do.", attendeeName);
         case Attendee::None:
-            return i18n("Unknown response to this to-do.");
+            return labels->todoUnknownResponse;
         }
         break;
     }
@@ -1712,8 +1921,10 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
     }
 
     QVariantList attendees;
-    const Attendee::List lstAttendees = incidence->attendees();
-    for (const Attendee &a : lstAttendees) {
+    const AttendeeClassifier classifier(incidence);
+    const Attendee::List &lstAttendees = classifier.attendees();
+    for (qsizetype i = 0; i < lstAttendees.size(); ++i) {
+        const Attendee &a = lstAttendees.at(i);
         if (iamAttendee(a)) {
             continue;
         }
@@ -1723,7 +1934,7 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
         attendee[QStringLiteral("email")] = a.email();
         attendee[QStringLiteral("delegator")] = a.delegator();
         attendee[QStringLiteral("delegate")] = a.delegate();
-        attendee[QStringLiteral("isOrganizer")] = attendeeIsOrganizer(incidence, a);
+        attendee[QStringLiteral("isOrganizer")] = classifier.isOrganizer(i);
         attendee[QStringLiteral("status")] = Stringify::attendeeStatus(a.status());
         attendee[QStringLiteral("icon")] = rsvpStatusIconName(a.status());
 
@@ -1740,12 +1951,13 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
     }
 
     QVariantList attendees;
-    const Attendee::List lstAttendees = incidence->attendees();
-    for (const Attendee &a_ : lstAttendees) {
-        Attendee a = a_;
-        if (!attendeeIsOrganizer(incidence, a)) {
+    const AttendeeClassifier classifier(incidence);
+    const Attendee::List &lstAttendees = classifier.attendees();
+    for (qsizetype i = 0; i < lstAttendees.size(); ++i) {
+        if (!classifier.isOrganizer(i)) {
             continue;
         }
+        Attendee a = lstAttendees.at(i);
         QVariantHash attendee;
         attendee[QStringLiteral("status")] = Stringify::attendeeStatus(a.status());
         if (!sender.isNull() && (a.email() == sender.email())) {
@@ -1771,6 +1983,12 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
     return attendees;
 }
 
+// The id of the link opening attachment @p a
+[[nodiscard]] static QString attachmentLinkId(const Attachment &a)
+{
+    return QStringLiteral("ATTACH:%1").arg(QString::fromLatin1(a.label().toUtf8().toBase64()));
+}
+
 [[nodiscard]] static QVariantList invitationAttachments(const Incidence::Ptr &incidence, InvitationFormatterHelper *helper)
 {
     if (!incidence) {
@@ -1790,7 +2008,7 @@ invitationHeaderTodo(const Todo::Ptr &todo, const Incidence::Ptr &existingIncide
         auto mimeType = mimeDb.mimeTypeForName(a.mimeType());
         attachment[QStringLiteral("icon")] = (mimeType.isValid() ? mimeType.iconName() : QStringLiteral("application-octet-stream"));
         attachment[QStringLiteral("name")] = a.label();
-        const QString attachementStr = helper->generateLinkURL(QStringLiteral("ATTACH:%1").arg(QString::fromLatin1(a.label().toUtf8().toBase64())));
+        const QString attachementStr = helper->generateLinkURL(attachmentLinkId(a));
         attachment[QStringLiteral("uri")] = attachementStr;
         attachments.push_back(attachment);
     }
@@ -1895,12 +2113,8 @@ private:
 };
 //@endcond
 
-class KCalUtils::InvitationFormatterHelperPrivate
-{
-};
-
 InvitationFormatterHelper::InvitationFormatterHelper()
-    : d(nullptr)
+    : d(new InvitationFormatterHelperPrivate)
 {
 }
 
@@ -1932,10 +2146,10 @@ static bool incidenceOwnedByMe([[maybe_unused]] const Calendar::Ptr &calendar, [
     return true;
 }
 
-static QVariantHash inviteButton(const QString &id, const QString &text, const QString &iconName, InvitationFormatterHelper *helper)
+static QVariantHash inviteButton(InvitationLink link, const QString &text, const QString &iconName, InvitationFormatterHelper *helper)
 {
     QVariantHash button;
-    button[QStringLiteral("uri")] = helper->generateLinkURL(id);
+    button[QStringLiteral("uri")] = helper->generateLinkURL(QLatin1StringView(sInvitationLinkIds[static_cast<std::size_t>(link)]));
     button[QStringLiteral("icon")] = iconName;
     button[QStringLiteral("label")] = text;
     return button;
@@ -1965,19 +2179,19 @@ static QVariantList responseButtons(const Incidence::Ptr &incidence,
     QVariantList buttons;
     if (!rsvpReq && (incidence && incidence->revision() == 0)) {
         // Record only
-        buttons << inviteButton(QStringLiteral("record"), i18n("Record"), QStringLiteral("dialog-ok"), helper);
+        buttons << inviteButton(InvitationLink::Record, i18n("Record"), QStringLiteral("dialog-ok"), helper);
 
         // Move to trash
-        buttons << inviteButton(QStringLiteral("delete"), i18n("Move to Trash"), QStringLiteral("edittrash"), helper);
+        buttons << inviteButton(InvitationLink::Delete, i18n("Move to Trash"), QStringLiteral("edittrash"), helper);
     } else {
         // Accept
         if (!hideAccept) {
-            buttons << inviteButton(QStringLiteral("accept"), i18nc("accept invitation", "Accept"), QStringLiteral("dialog-ok-apply"), helper);
+            buttons << inviteButton(InvitationLink::Accept, i18nc("accept invitation", "Accept"), QStringLiteral("dialog-ok-apply"), helper);
         }
 
         // Tentative
         if (!hideTentative) {
-            buttons << inviteButton(QStringLiteral("accept_conditionally"),
+            buttons << inviteButton(InvitationLink::AcceptConditionally,
                                     i18nc("Accept invitation conditionally", "Tentative"),
                                     QStringLiteral("dialog-ok"),
                                     helper);
@@ -1985,16 +2199,16 @@ static QVariantList responseButtons(const Incidence::Ptr &incidence,
 
         // Decline
         if (!hideDecline) {
-            buttons << inviteButton(QStringLiteral("decline"), i18nc("decline invitation", "Decline"), QStringLiteral("dialog-cancel"), helper);
+            buttons << inviteButton(InvitationLink::Decline, i18nc("decline invitation", "Decline"), QStringLiteral("dialog-cancel"), helper);
         }
 
         // Counter proposal
-        buttons << inviteButton(QStringLiteral("counter"), i18nc("invitation counter proposal", "Counter proposal ..."), QStringLiteral("edit-undo"), helper);
+        buttons << inviteButton(InvitationLink::Counter, i18nc("invitation counter proposal", "Counter proposal ..."), QStringLiteral("edit-undo"), helper);
     }
 
     if (!rsvpRec || (incidence && incidence->revision() > 0)) {
         // Delegate
-        buttons << inviteButton(QStringLiteral("delegate"), i18nc("delegate invitation to another", "Delegate ..."), QStringLiteral("mail-forward"), helper);
+        buttons << inviteButton(InvitationLink::Delegate, i18nc("delegate invitation to another", "Delegate ..."), QStringLiteral("mail-forward"), helper);
     }
     return buttons;
 }
@@ -2004,10 +2218,10 @@ static QVariantList responseButtons(const Incidence::Ptr &incidence,
     QVariantList buttons;
 
     // Accept proposal
-    buttons << inviteButton(QStringLiteral("accept_counter"), i18n("Accept"), QStringLiteral("dialog-ok-apply"), helper);
+    buttons << inviteButton(InvitationLink::AcceptCounter, i18n("Accept"), QStringLiteral("dialog-ok-apply"), helper);
 
     // Decline proposal
-    buttons << inviteButton(QStringLiteral("decline_counter"), i18n("Decline"), QStringLiteral("dialog-cancel"), helper);
+    buttons << inviteButton(InvitationLink::DeclineCounter, i18n("Decline"), QStringLiteral("dialog-cancel"), helper);
 
     return buttons;
 }
@@ -2016,7 +2230,7 @@ static QVariantList responseButtons(const Incidence::Ptr &incidence,
 {
     QVariantList buttons;
     if (incidence) {
-        buttons << inviteButton(QStringLiteral("reply"),
+        buttons << inviteButton(InvitationLink::Reply,
                                 incidence->type() == Incidence::TypeTodo ? i18n("Record invitation in my to-do list")
                                                                          : i18n("Record invitation in my calendar"),
                                 QStringLiteral("dialog-ok"),
@@ -2030,7 +2244,7 @@ static QVariantList responseButtons(const Incidence::Ptr &incidence,
     QVariantList buttons;
 
     if (incidence) {
-        buttons << inviteButton(QStringLiteral("reply"),
+        buttons << inviteButton(InvitationLink::Reply,
                                 incidence->type() == Incidence::TypeTodo ? i18n("Record response in my to-do list") : i18n("Record response in my calendar"),
                                 QStringLiteral("dialog-ok"),
                                 helper);
@@ -2044,7 +2258,7 @@ static QVariantList responseButtons(const Incidence::Ptr &incidence,
 
     // Remove invitation
     if (incidence) {
-        buttons << inviteButton(QStringLiteral("cancel"),
+        buttons << inviteButton(InvitationLink::Cancel,
                                 incidence->type() == Incidence::TypeTodo ? i18n("Remove invitation from my to-do list")
                                                                          : i18n("Remove invitation from my calendar"),
                                 QStringLiteral("dialog-cancel"),
@@ -2070,14 +2284,47 @@ Calendar::Ptr InvitationFormatterHelper::calendar() const
     return Calendar::Ptr();
 }
 
-static QString
-formatICalInvitationHelper(const QString &invitation, const Calendar::Ptr &mCalendar, InvitationFormatterHelper *helper, bool noHtmlMode, const QString &sender)
+[[nodiscard]] static Incidence::Ptr
+findExistingIncidence(const Calendar::Ptr &calendar, const IncidenceBase::Ptr &incBase, InvitationFormatterHelper *helper)
+{
+    Incidence::Ptr existingIncidence = calendar->incidence(incBase->uid(), incBase->recurrenceId());
+
+    /* cppcheck-suppress knownConditionTrueFalse */
+    if (!incidenceOwnedByMe(calendar, existingIncidence)) {
+        existingIncidence.clear();
+    }
+    if (!existingIncidence) {
+        // Only index the calendar when the invitation has to be looked up by scheduling ID.
+        // Copies of the invitation may share the key, only one of them can be ours
+        const IncidenceLookupIndex *lookupIndex = InvitationFormatterHelperPrivate::get(helper)->lookupIndex(calendar);
+        const Incidence::List candidates = lookupIndex->find(incBase->uid(), incBase->recurrenceId());
+        const auto it = std::find_if(candidates.cbegin(), candidates.cend(), [&calendar](const Incidence::Ptr &candidate) {
+            return incidenceOwnedByMe(calendar, candidate);
+        });
+        if (it != candidates.cend()) {
+            existingIncidence = *it;
+        }
+    }
+    return existingIncidence;
+}
+
+static QVariantHash invitationModelHelper(const QString &invitation,
+                                          const Calendar::Ptr &mCalendar,
+                                          InvitationFormatterHelper *helper,
+                                          bool noHtmlMode,
+                                          const QString &sender,
+                                          ICalFormat &format,
+                                          const QPromise<QString> *promise = nullptr)
 {
     if (invitation.isEmpty()) {
-        return QString();
+        return QVariantHash();
     }
 
-    ICalFormat format;
+    // Asynchronous renders give up between the stages once canceled
+    const auto isCanceled = [promise]() {
+        return promise && promise->isCanceled();
+    };
+
     // parseScheduleMessage takes the tz from the calendar,
     // no need to set it manually here for the format!
     ScheduleMessage::Ptr const msg = format.parseScheduleMessage(mCalendar, invitation);
@@ -2086,7 +2333,11 @@ formatICalInvitationHelper(const QString &invitation, const Calendar::Ptr &mCale
         qCDebug(KCALUTILS_LOG) << "Failed to parse the scheduling message";
         Q_ASSERT(format.exception());
         qCDebug(KCALUTILS_LOG) << Stringify::errorMessage(*format.exception());
-        return QString();
+        return QVariantHash();
+    }
+
+    if (isCanceled()) {
+        return QVariantHash();
     }
 
     IncidenceBase::Ptr const incBase = msg->event();
@@ -2095,24 +2346,12 @@ formatICalInvitationHelper(const QString &invitation, const Calendar::Ptr &mCale
 
     // Determine if this incidence is in my calendar (and owned by me)
     Incidence::Ptr existingIncidence;
-    if (incBase && helper->calendar()) {
-        existingIncidence = helper->calendar()->incidence(incBase->uid(), incBase->recurrenceId());
-
-        /* cppcheck-suppress knownConditionTrueFalse */
-        if (!incidenceOwnedByMe(helper->calendar(), existingIncidence)) {
-            existingIncidence.clear();
-        }
-        if (!existingIncidence) {
-            const Incidence::List list = helper->calendar()->incidences();
-            for (Incidence::List::ConstIterator it = list.begin(), end = list.end(); it != end; ++it) {
-                /* cppcheck-suppress knownConditionTrueFalse */
-                if ((*it)->schedulingID() == incBase->uid() && incidenceOwnedByMe(helper->calendar(), *it)
-                    && (*it)->recurrenceId() == incBase->recurrenceId()) {
-                    existingIncidence = *it;
-                    break;
-                }
-            }
-        }
+    const Calendar::Ptr helperCalendar = incBase ? helper->calendar() : Calendar::Ptr();
+    if (helperCalendar) {
+        existingIncidence = findExistingIncidence(helperCalendar, incBase, helper);
+    }
+    if (isCanceled()) {
+        return QVariantHash();
     }
 
     Incidence::Ptr const inc = incBase.staticCast<Incidence>(); // the incidence in the invitation email
@@ -2127,7 +2366,7 @@ formatICalInvitationHelper(const QString &invitation, const Calendar::Ptr &mCale
     IncidenceFormatter::InvitationHeaderVisitor headerVisitor;
     // The InvitationHeaderVisitor returns false if the incidence is somehow invalid, or not handled
     if (!headerVisitor.act(inc, existingIncidence, msg, sender)) {
-        return QString();
+        return QVariantHash();
     }
 
     QVariantHash incidence;
@@ -2144,8 +2383,8 @@ formatICalInvitationHelper(const QString &invitation, const Calendar::Ptr &mCale
     } else {
         bodyOk = bodyVisitor.act(inc, Incidence::Ptr(), msg, sender);
     }
-    if (!bodyOk) {
-        return QString();
+    if (!bodyOk || isCanceled()) {
+        return QVariantHash();
     }
 
     incidence = bodyVisitor.result();
@@ -2286,7 +2525,7 @@ formatICalInvitationHelper(const QString &invitation, const Calendar::Ptr &mCale
         }
         if (!ea.isNull() && (ea.status() != Attendee::NeedsAction) && (ea.status() == a.status())) {
             const QString tStr = i18n("The <b>%1</b> response has been recorded", Stringify::attendeeStatus(ea.status()));
-            buttons << inviteButton(QString(), tStr, QString(), helper);
+            buttons << inviteButton(InvitationLink::None, tStr, QString(), helper);
         } else {
             if (inc) {
                 buttons = recordResponseButtons(inc, helper);
@@ -2329,32 +2568,142 @@ formatICalInvitationHelper(const QString &invitation, const Calendar::Ptr &mCale
         incidence[QStringLiteral("comments")] = inc->comments();
     }
 
-    QString templateName;
+    // Selects the template the model is rendered with
     switch (inc->type()) {
     case KCalendarCore::IncidenceBase::TypeEvent:
-        templateName = QStringLiteral("org.kde.pim/kcalutils/itip_event.html");
+        incidence[QStringLiteral("type")] = QStringLiteral("event");
         break;
     case KCalendarCore::IncidenceBase::TypeTodo:
-        templateName = QStringLiteral("org.kde.pim/kcalutils/itip_todo.html");
+        incidence[QStringLiteral("type")] = QStringLiteral("todo");
         break;
     case KCalendarCore::IncidenceBase::TypeJournal:
-        templateName = QStringLiteral("org.kde.pim/kcalutils/itip_journal.html");
+        incidence[QStringLiteral("type")] = QStringLiteral("journal");
         break;
     case KCalendarCore::IncidenceBase::TypeFreeBusy:
-        templateName = QStringLiteral("org.kde.pim/kcalutils/itip_freebusy.html");
+        incidence[QStringLiteral("type")] = QStringLiteral("freebusy");
         break;
     case KCalendarCore::IncidenceBase::TypeUnknown:
+        return QVariantHash();
+    }
+
+    return incidence;
+}
+
+[[nodiscard]] static QString renderInvitationModel(const QVariantHash &model)
+{
+    // The type picks the template, models may come from the caller
+    static const QStringList types = {QStringLiteral("event"), QStringLiteral("todo"), QStringLiteral("journal"), QStringLiteral("freebusy")};
+    const QString type = model.value(QStringLiteral("type")).toString();
+    if (!types.contains(type)) {
         return QString();
     }
+    return GrantleeTemplateManager::instance()->render(QStringLiteral("org.kde.pim/kcalutils/itip_%1.html").arg(type), model);
+}
 
-    return GrantleeTemplateManager::instance()->render(templateName, incidence);
+static QString formatICalInvitationHelper(const QString &invitation,
+                                          const Calendar::Ptr &mCalendar,
+                                          InvitationFormatterHelper *helper,
+                                          bool noHtmlMode,
+                                          const QString &sender,
+                                          ICalFormat &format,
+                                          const QPromise<QString> *promise = nullptr)
+{
+    const QVariantHash model = invitationModelHelper(invitation, mCalendar, helper, noHtmlMode, sender, format, promise);
+    if (model.isEmpty() || (promise && promise->isCanceled())) {
+        return QString();
+    }
+    return renderInvitationModel(model);
+}
+
+// The ids of the attachment links of @p invitation, as invitationAttachments() builds them
+[[nodiscard]] static QStringList attachmentLinkIds(const QString &invitation, const Calendar::Ptr &calendar)
+{
+    ICalFormat format;
+    const ScheduleMessage::Ptr msg = format.parseScheduleMessage(calendar, invitation);
+    const IncidenceBase::Ptr incBase = msg ? msg->event() : IncidenceBase::Ptr();
+    if (!incBase || incBase->type() == IncidenceBase::TypeFreeBusy) {
+        return QStringList();
+    }
+
+    QStringList ids;
+    const Attachment::List attachments = incBase.staticCast<Incidence>()->attachments();
+    ids.reserve(attachments.size());
+    for (const Attachment &a : attachments) {
+        ids.append(attachmentLinkId(a));
+    }
+    return ids;
+}
+
+namespace
+{
+// Stands in for the helper of an asynchronous render. It carries what the worker
+// needs from the helper, which may be gone by the time the worker runs and is
+// not expected to be usable from other threads
+class InvitationHelperSnapshot : public InvitationFormatterHelper
+{
+public:
+    InvitationHelperSnapshot(InvitationFormatterHelper *helper, const QString &invitation, const Calendar::Ptr &calendar)
+        : mCalendar(helper->calendar())
+    {
+        for (const char *id : sInvitationLinkIds) {
+            const QString linkId = QLatin1StringView(id);
+            mLinks.insert(linkId, helper->generateLinkURL(linkId));
+        }
+        // The attachment links depend on the labels, as parsed by the worker
+        const QStringList attachmentIds = attachmentLinkIds(invitation, calendar);
+        for (const QString &id : attachmentIds) {
+            mLinks.insert(id, helper->generateLinkURL(id));
+        }
+
+        // Binding the indexes registers observers on the calendar, do it in this thread
+        if (mCalendar) {
+            InvitationFormatterHelperPrivate::get(this)->share(InvitationFormatterHelperPrivate::get(helper), mCalendar);
+        }
+    }
+
+    [[nodiscard]] QString generateLinkURL(const QString &id) override
+    {
+        const auto it = mLinks.constFind(id);
+        if (it == mLinks.cend()) {
+            qCWarning(KCALUTILS_LOG) << "No link URL was resolved for" << id;
+            Q_ASSERT_X(false, "InvitationHelperSnapshot::generateLinkURL", "link not resolved up front");
+            return InvitationFormatterHelper::generateLinkURL(id);
+        }
+        return *it;
+    }
+
+    [[nodiscard]] Calendar::Ptr calendar() const override
+    {
+        return mCalendar;
+    }
+
+private:
+    const Calendar::Ptr mCalendar;
+    QHash<QString, QString> mLinks;
+};
 }
 
 //@endcond
 
 QString IncidenceFormatter::formatICalInvitation(const QString &invitation, const Calendar::Ptr &calendar, InvitationFormatterHelper *helper)
 {
-    return formatICalInvitationHelper(invitation, calendar, helper, false, QString());
+    ICalFormat format;
+    return formatICalInvitationHelper(invitation, calendar, helper, false, QString(), format);
+}
+
+QVariantHash IncidenceFormatter::formatICalInvitationModel(const QString &invitation,
+                                                          const Calendar::Ptr &calendar,
+                                                          InvitationFormatterHelper *helper,
+                                                          bool noHtmlMode,
+                                                          const QString &sender)
+{
+    ICalFormat format;
+    return invitationModelHelper(invitation, calendar, helper, noHtmlMode, sender, format);
+}
+
+QString IncidenceFormatter::renderICalInvitationModel(const QVariantHash &model)
+{
+    return renderInvitationModel(model);
 }
 
 QString IncidenceFormatter::formatICalInvitationNoHtml(const QString &invitation,
@@ -2362,7 +2711,68 @@ QString IncidenceFormatter::formatICalInvitationNoHtml(const QString &invitation
                                                        InvitationFormatterHelper *helper,
                                                        const QString &sender)
 {
-    return formatICalInvitationHelper(invitation, calendar, helper, true, sender);
+    ICalFormat format;
+    return formatICalInvitationHelper(invitation, calendar, helper, true, sender, format);
+}
+
+QStringList
+IncidenceFormatter::formatICalInvitations(const QStringList &invitations,
+                                          const Calendar::Ptr &calendar,
+                                          InvitationFormatterHelper *helper,
+                                          bool parallel,
+                                          QThreadPool *pool)
+{
+    if (invitations.isEmpty()) {
+        return {};
+    }
+
+    if (!parallel || invitations.size() == 1) {
+        ICalFormat format;
+        QStringList results;
+        results.reserve(invitations.size());
+        for (const QString &invitation : invitations) {
+            results.append(formatICalInvitationHelper(invitation, calendar, helper, false, QString(), format));
+        }
+        return results;
+    }
+
+    // Bind the helper indexes here, the workers only read from them
+    InvitationFormatterHelperPrivate *const d = InvitationFormatterHelperPrivate::get(helper);
+    const Calendar::Ptr helperCalendar = helper->calendar();
+    (void)d->lookupIndex(helperCalendar);
+    (void)d->conflictIndex(helperCalendar);
+
+    // Create the identity manager in the calling thread before the workers need it
+    (void)thatIsMe(QString());
+
+    return QtConcurrent::blockingMapped(pool ? pool : QThreadPool::globalInstance(), invitations, [&](const QString &invitation) {
+        ICalFormat format;
+        return formatICalInvitationHelper(invitation, calendar, helper, false, QString(), format);
+    });
+}
+
+QFuture<QString> IncidenceFormatter::formatICalInvitationAsync(const QString &invitation,
+                                                              const Calendar::Ptr &calendar,
+                                                              InvitationFormatterHelper *helper,
+                                                              bool noHtmlMode,
+                                                              const QString &sender,
+                                                              QThreadPool *pool)
+{
+    // The worker never touches the helper, only what it needs from it, taken here
+    const auto snapshot = std::make_shared<InvitationHelperSnapshot>(helper, invitation, calendar);
+
+    // Create the identity manager in the calling thread before the worker needs it
+    (void)thatIsMe(QString());
+
+    return QtConcurrent::run(pool ? pool : QThreadPool::globalInstance(),
+                             [invitation, calendar, snapshot, noHtmlMode, sender](QPromise<QString> &promise) {
+                                 ICalFormat format;
+                                 const QString result =
+                                     formatICalInvitationHelper(invitation, calendar, snapshot.get(), noHtmlMode, sender, format, &promise);
+                                 if (!promise.isCanceled()) {
+                                     promise.addResult(result);
+                                 }
+                             });
 }
 
 /*******************************************************************
@@ -2422,11 +2832,9 @@ protected:
 
 QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const Event::Ptr &event, QDate date)
 {
-    // FIXME: support mRichText==false
-    QString ret;
-    QString tmp;
+    HtmlWriter html(256, mRichText);
 
-    const auto startDts = event->startDateTimesForDate(date, QTimeZone::systemTimeZone());
+    const auto startDts = OccurrenceCache::startDateTimesForDate(event, date, QTimeZone::systemTimeZone());
     QDateTime startDt;
     QDateTime endDt;
     if (startDts.isEmpty()) {
@@ -2444,33 +2852,34 @@ QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const Event::Ptr &even
 
     if (event->isMultiDay()) {
         if (event->allDay()) {
-            tmp = QLocale().toString(startDt.date(), QLocale::ShortFormat);
-            ret += QLatin1StringView("<br>") + i18nc("Event start", "<i>From:</i> %1", tmp);
-            tmp = QLocale().toString(endDt.date(), QLocale::ShortFormat);
-            ret += QLatin1StringView("<br>") + i18nc("Event end", "<i>To:</i> %1", tmp);
+            html.lineBreak();
+            html.field(i18nc("Event start", "<i>From:</i> %1", QLocale().toString(startDt.date(), QLocale::ShortFormat)));
+            html.lineBreak();
+            html.field(i18nc("Event end", "<i>To:</i> %1", QLocale().toString(endDt.date(), QLocale::ShortFormat)));
         } else {
-            ret += QLatin1StringView("<br>") + i18nc("datetime range for event", "<i>Date:</i> %1 - %2", dateTimeToString(startDt), dateTimeToString(endDt));
+            html.lineBreak();
+            html.field(i18nc("datetime range for event", "<i>Date:</i> %1 - %2", dateTimeToString(startDt), dateTimeToString(endDt)));
         }
     } else {
-        ret += QLatin1StringView("<br>") + i18n("<i>Date:</i> %1", QLocale().toString(startDt.date(), QLocale::LongFormat));
+        html.lineBreak();
+        html.field(i18n("<i>Date:</i> %1", QLocale().toString(startDt.date(), QLocale::LongFormat)));
         if (!event->allDay()) {
             const QString dtStartTime = QLocale().toString(startDt.time(), QLocale::ShortFormat);
             const QString dtEndTime = QLocale().toString(endDt.time(), QLocale::ShortFormat);
+            html.lineBreak();
             if (dtStartTime == dtEndTime) {
                 // to prevent 'Time: 17:00 - 17:00'
-                tmp = QLatin1StringView("<br>") + i18nc("time for event", "<i>Time:</i> %1", dtStartTime);
+                html.field(i18nc("time for event", "<i>Time:</i> %1", dtStartTime));
             } else {
-                tmp = QLatin1StringView("<br>") + i18nc("time range for event", "<i>Time:</i> %1 - %2", dtStartTime, dtEndTime);
+                html.field(i18nc("time range for event", "<i>Time:</i> %1 - %2", dtStartTime, dtEndTime));
             }
-            ret += tmp;
         }
     }
-    return ret.replace(u' ', QLatin1StringView("&nbsp;"));
+    return html.take();
 }
 
 QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const Todo::Ptr &todo, QDate asOfDate)
 {
-    // FIXME: support mRichText==false
     // FIXME: doesn't handle to-dos that occur more than once per day.
 
     QDateTime startDt{todo->dtStart(false)};
@@ -2478,7 +2887,7 @@ QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const Todo::Ptr &todo,
 
     if (todo->recurs() && asOfDate.isValid()) {
         const QDateTime limit{asOfDate.addDays(1), QTime(0, 0, 0), QTimeZone::LocalTime};
-        startDt = todo->recurrence()->getPreviousDateTime(limit);
+        startDt = OccurrenceCache::previousDateTime(todo, limit);
         if (startDt.isValid() && todo->hasDueDate()) {
             if (todo->allDay()) {
                 // Days, not seconds, because not all days are 24 hours long.
@@ -2491,24 +2900,26 @@ QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const Todo::Ptr &todo,
         }
     }
 
-    QString ret;
+    HtmlWriter html(256, mRichText);
     if (startDt.isValid()) {
-        ret = QLatin1StringView("<br>") % i18nc("To-do's start date", "<i>Start:</i> %1", dateTimeToString(startDt, todo->allDay(), false));
+        html.lineBreak();
+        html.field(i18nc("To-do's start date", "<i>Start:</i> %1", dateTimeToString(startDt, todo->allDay(), false)));
     }
     if (dueDt.isValid()) {
-        ret += QLatin1StringView("<br>") % i18nc("To-do's due date", "<i>Due:</i> %1", dateTimeToString(dueDt, todo->allDay(), false));
+        html.lineBreak();
+        html.field(i18nc("To-do's due date", "<i>Due:</i> %1", dateTimeToString(dueDt, todo->allDay(), false)));
     }
 
     // Print priority and completed info here, for lack of a better place
 
     if (todo->priority() > 0) {
-        ret += QLatin1StringView("<br>")
-            % i18nc("To-do's priority number", "<i>Priority:</i> %1", QString::number(todo->priority())); // krazy:exclude=i18ncheckarg
+        html.lineBreak();
+        html.field(i18nc("To-do's priority number", "<i>Priority:</i> %1", QString::number(todo->priority()))); // krazy:exclude=i18ncheckarg
     }
 
-    ret += QLatin1StringView("<br>");
+    html.lineBreak();
     if (todo->hasCompletedDate()) {
-        ret += i18nc("To-do's completed date", "<i>Completed:</i> %1", QLocale().toString(todo->completed(), QLocale::LongFormat));
+        html.field(i18nc("To-do's completed date", "<i>Completed:</i> %1", QLocale().toString(todo->completed(), QLocale::LongFormat)));
     } else {
         int pct = todo->percentComplete();
         if (todo->recurs() && asOfDate.isValid()) {
@@ -2519,28 +2930,30 @@ QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const Todo::Ptr &todo,
                 pct = 100;
             }
         }
-        ret += i18nc("To-do's percent complete:", "<i>Percent Done:</i> %1%", pct);
+        html.field(i18nc("To-do's percent complete:", "<i>Percent Done:</i> %1%", pct));
     }
 
-    return ret.replace(u' ', QLatin1StringView("&nbsp;"));
+    return html.take();
 }
 
 QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const Journal::Ptr &journal)
 {
-    // FIXME: support mRichText==false
-    QString ret;
+    HtmlWriter html(128, mRichText);
     if (journal->dtStart().isValid()) {
-        ret += QLatin1StringView("<br>") + i18n("<i>Date:</i> %1", QLocale().toString(journal->dtStart().toLocalTime().date(), QLocale::LongFormat));
+        html.lineBreak();
+        html.field(i18n("<i>Date:</i> %1", QLocale().toString(journal->dtStart().toLocalTime().date(), QLocale::LongFormat)));
     }
-    return ret.replace(u' ', QLatin1StringView("&nbsp;"));
+    return html.take();
 }
 
 QString IncidenceFormatter::ToolTipVisitor::dateRangeText(const FreeBusy::Ptr &fb)
 {
-    // FIXME: support mRichText==false
-    QString ret = QLatin1StringView("<br>") + i18n("<i>Period start:</i> %1", QLocale().toString(fb->dtStart(), QLocale::ShortFormat));
-    ret += QLatin1StringView("<br>") + i18n("<i>Period end:</i> %1", QLocale().toString(fb->dtEnd(), QLocale::ShortFormat));
-    return ret.replace(u' ', QLatin1StringView("&nbsp;"));
+    HtmlWriter html(128, mRichText);
+    html.lineBreak();
+    html.field(i18n("<i>Period start:</i> %1", QLocale().toString(fb->dtStart(), QLocale::ShortFormat)));
+    html.lineBreak();
+    html.field(i18n("<i>Period end:</i> %1", QLocale().toString(fb->dtEnd(), QLocale::ShortFormat)));
+    return html.take();
 }
 
 bool IncidenceFormatter::ToolTipVisitor::visit(const Event::Ptr &event)
@@ -2563,200 +2976,212 @@ bool IncidenceFormatter::ToolTipVisitor::visit(const Journal::Ptr &journal)
 
 bool IncidenceFormatter::ToolTipVisitor::visit(const FreeBusy::Ptr &fb)
 {
-    // FIXME: support mRichText==false
-    mResult = QLatin1StringView("<qt><b>") + i18n("Free/Busy information for %1", fb->organizer().fullName()) + QLatin1StringView("</b>");
+    const QString title = i18n("Free/Busy information for %1", fb->organizer().fullName());
+    if (!mRichText) {
+        mResult = title + dateRangeText(fb);
+        return !mResult.isEmpty();
+    }
+    mResult = QLatin1StringView("<qt><b>") + title + QLatin1StringView("</b>");
     mResult += dateRangeText(fb);
     mResult += QLatin1StringView("</qt>");
     return !mResult.isEmpty();
 }
 
-[[nodiscard]] static QString tooltipPerson(const QString &email, const QString &name, Attendee::PartStat status)
+static void tooltipPerson(HtmlWriter &html, const QString &email, const QString &name, Attendee::PartStat status)
 {
     // Search for a new print name, if needed.
     const QString printName = searchName(email, name);
 
     // Get the icon corresponding to the attendee participation status.
-    const QString iconPath = KIconLoader::global()->iconPath(rsvpStatusIconName(status), KIconLoader::Small);
+    if (html.richText()) {
+        const QString iconPath = KCalUtils::iconPath(rsvpStatusIconName(status), KIconLoader::Small);
+        if (!iconPath.isEmpty()) {
+            html << QLatin1StringView(R"(<img valign="top" src=")") << iconPath << QLatin1StringView("\">&nbsp;");
+        }
+    }
 
     // Make the return string.
-    QString personString;
-    if (!iconPath.isEmpty()) {
-        personString += QLatin1StringView(R"(<img valign="top" src=")") + iconPath + QLatin1StringView("\">") + QLatin1StringView("&nbsp;");
-    }
     if (status != Attendee::None) {
-        personString += i18nc("attendee name (attendee status)", "%1 (%2)", printName.isEmpty() ? email : printName, Stringify::attendeeStatus(status));
+        html << i18nc("attendee name (attendee status)", "%1 (%2)", printName.isEmpty() ? email : printName, Stringify::attendeeStatus(status));
     } else {
-        personString += i18n("%1", printName.isEmpty() ? email : printName);
+        html << i18n("%1", printName.isEmpty() ? email : printName);
     }
-    return personString;
 }
 
-[[nodiscard]] static QString tooltipFormatOrganizer(const QString &email, const QString &name)
+static void tooltipFormatOrganizer(HtmlWriter &html, const QString &email, const QString &name)
 {
     // Search for a new print name, if needed
     const QString printName = searchName(email, name);
 
     // Get the icon for organizer
-    // TODO fixme laurent: use another icon. It doesn't exist in breeze.
-    const QString iconPath = KIconLoader::global()->iconPath(QStringLiteral("meeting-organizer"), KIconLoader::Small, true);
+    if (html.richText()) {
+        // TODO fixme laurent: use another icon. It doesn't exist in breeze.
+        const QString iconPath = KCalUtils::iconPath(QStringLiteral("meeting-organizer"), KIconLoader::Small, true);
+        if (!iconPath.isEmpty()) {
+            html << QLatin1StringView(R"(<img valign="top" src=")") << iconPath << QLatin1StringView("\">&nbsp;");
+        }
+    }
 
     // Make the return string.
-    QString personString;
-    if (!iconPath.isEmpty()) {
-        personString += QLatin1StringView(R"(<img valign="top" src=")") + iconPath + QLatin1StringView("\">") + QLatin1StringView("&nbsp;");
-    }
-    personString += (printName.isEmpty() ? email : printName);
-    return personString;
+    html << (printName.isEmpty() ? email : printName);
 }
 
-[[nodiscard]] static QString tooltipFormatAttendeeRoleList(const Incidence::Ptr &incidence, Attendee::Role role, bool showStatus)
+// Returns false if no attendee has the given role
+static bool
+tooltipFormatAttendeeRoleList(HtmlWriter &html, const FormatterLabels &labels, const AttendeeClassifier &attendees, Attendee::Role role, bool showStatus)
 {
     int const maxNumAtts = 8; // maximum number of people to print per attendee role
-    const QString etc = i18nc("ellipsis", "...");
 
     int i = 0;
-    QString tmpStr;
-    const Attendee::List attendees = incidence->attendees();
-    for (const auto &a : attendees) {
-        if (a.role() != role) {
-            // skip not this role
-            continue;
-        }
-        if (attendeeIsOrganizer(incidence, a)) {
-            // skip attendee that is also the organizer
-            continue;
-        }
+    bool written = false;
+    for (const auto &a : attendees.withRole(role)) {
         if (i == maxNumAtts) {
-            tmpStr += QLatin1StringView("&nbsp;&nbsp;") + etc;
-            break;
+            html.indent();
+            html << labels.ellipsis;
+            return true;
         }
-        tmpStr += QLatin1StringView("&nbsp;&nbsp;") + tooltipPerson(a.email(), a.name(), showStatus ? a.status() : Attendee::None);
+        html.indent();
+        tooltipPerson(html, a.email(), a.name(), showStatus ? a.status() : Attendee::None);
         if (!a.delegator().isEmpty()) {
-            tmpStr += i18n(" (delegated by %1)", a.delegator());
+            html << labels.delegatedByPattern.arg(a.delegator());
         }
         if (!a.delegate().isEmpty()) {
-            tmpStr += i18n(" (delegated to %1)", a.delegate());
+            html << labels.delegatedToPattern.arg(a.delegate());
         }
-        tmpStr += QLatin1StringView("<br>");
+        html.lineBreak();
+        written = true;
         i++;
     }
-    if (tmpStr.endsWith(QLatin1StringView("<br>"))) {
-        tmpStr.chop(4);
+    if (written) {
+        html.chopLineBreak();
     }
-    return tmpStr;
+    return written;
 }
 
-[[nodiscard]] static QString tooltipFormatAttendees(const Calendar::Ptr &calendar, const Incidence::Ptr &incidence)
+// Returns false if nothing was written
+static bool tooltipFormatAttendees(HtmlWriter &html, const FormatterLabels &labels, const Calendar::Ptr &calendar, const Incidence::Ptr &incidence)
 {
-    QString tmpStr;
-    QString str;
+    const qsizetype start = html.size();
 
     // Add organizer link
-    const int attendeeCount = incidence->attendees().count();
-    if (attendeeCount > 1 || (attendeeCount == 1 && !attendeeIsOrganizer(incidence, incidence->attendees().at(0)))) {
-        tmpStr += QLatin1StringView("<i>") + i18n("Organizer:") + QLatin1StringView("</i>") + QLatin1StringView("<br>");
-        tmpStr += QLatin1StringView("&nbsp;&nbsp;") + tooltipFormatOrganizer(incidence->organizer().email(), incidence->organizer().name());
+    const AttendeeClassifier attendees(incidence);
+    if (attendees.showOrganizer()) {
+        html.label(labels.organizer, true);
+        html.indent();
+        tooltipFormatOrganizer(html, incidence->organizer().email(), incidence->organizer().name());
     }
 
     // Show the attendee status if the incidence's organizer owns the resource calendar,
     // which means they are running the show and have all the up-to-date response info.
-    const bool showStatus = attendeeCount > 0 && incOrganizerOwnsCalendar(calendar, incidence);
+    const bool showStatus = !attendees.attendees().isEmpty() && incOrganizerOwnsCalendar(calendar, incidence);
+
+    const auto addRoleList = [&](Attendee::Role role, const QString &title) {
+        const qsizetype mark = html.size();
+        html.lineBreak();
+        html.label(title, true);
+        if (!tooltipFormatAttendeeRoleList(html, labels, attendees, role, showStatus)) {
+            // drop the heading of an empty role
+            html.truncate(mark);
+        }
+    };
 
     // Add "chair"
-    str = tooltipFormatAttendeeRoleList(incidence, Attendee::Chair, showStatus);
-    if (!str.isEmpty()) {
-        tmpStr += QLatin1StringView("<br><i>") + i18n("Chair:") + QLatin1StringView("</i>") + QLatin1StringView("<br>");
-        tmpStr += str;
-    }
+    addRoleList(Attendee::Chair, labels.chair);
 
     // Add required participants
-    str = tooltipFormatAttendeeRoleList(incidence, Attendee::ReqParticipant, showStatus);
-    if (!str.isEmpty()) {
-        tmpStr += QLatin1StringView("<br><i>") + i18n("Required Participants:") + QLatin1StringView("</i>") + QLatin1StringView("<br>");
-        tmpStr += str;
-    }
+    addRoleList(Attendee::ReqParticipant, labels.requiredParticipants);
 
     // Add optional participants
-    str = tooltipFormatAttendeeRoleList(incidence, Attendee::OptParticipant, showStatus);
-    if (!str.isEmpty()) {
-        tmpStr += QLatin1StringView("<br><i>") + i18n("Optional Participants:") + QLatin1StringView("</i>") + QLatin1StringView("<br>");
-        tmpStr += str;
-    }
+    addRoleList(Attendee::OptParticipant, labels.optionalParticipants);
 
     // Add observers
-    str = tooltipFormatAttendeeRoleList(incidence, Attendee::NonParticipant, showStatus);
-    if (!str.isEmpty()) {
-        tmpStr += QLatin1StringView("<br><i>") + i18n("Observers:") + QLatin1StringView("</i>") + QLatin1StringView("<br>");
-        tmpStr += str;
-    }
+    addRoleList(Attendee::NonParticipant, labels.observers);
 
-    return tmpStr;
+    return html.size() > start;
 }
 
 QString IncidenceFormatter::ToolTipVisitor::generateToolTip(const Incidence::Ptr &incidence, const QString &dtRangeText)
 {
-    // FIXME: support mRichText==false
     if (!incidence) {
         return QString();
     }
 
-    QString tmp = QStringLiteral("<qt>");
+    const std::shared_ptr<const FormatterLabels> labels = FormatterLabels::get();
+
+    HtmlWriter html(1024, mRichText);
+    if (mRichText) {
+        html << QLatin1StringView("<qt>");
+    }
 
     // header
-    tmp += QLatin1StringView("<b>") + incidence->richSummary() + QLatin1StringView("</b>");
-    tmp += QLatin1StringView("<hr>");
+    if (mRichText) {
+        html << QLatin1StringView("<b>") << incidence->richSummary() << QLatin1StringView("</b>");
+    } else {
+        html << (incidence->summaryIsRich() ? cleanHtml(incidence->summary()) : incidence->summary());
+    }
+    html.rule();
 
     QString calStr = mLocation;
     if (mCalendar) {
         calStr = resourceString(mCalendar, incidence);
     }
     if (!calStr.isEmpty()) {
-        tmp += QLatin1StringView("<i>") + i18n("Calendar:") + QLatin1StringView("</i>") + QLatin1StringView("&nbsp;");
-        tmp += calStr;
+        html.label(labels->calendar);
+        html << calStr;
     }
 
-    tmp += dtRangeText;
+    html << dtRangeText;
 
     if (!incidence->location().isEmpty()) {
-        tmp += QLatin1StringView("<br>");
-        tmp += QLatin1StringView("<i>") + i18n("Location:") + QLatin1StringView("</i>") + QLatin1StringView("&nbsp;");
-        tmp += incidence->richLocation();
+        html.lineBreak();
+        html.label(labels->location);
+        if (mRichText) {
+            html << incidence->richLocation();
+        } else {
+            html << (incidence->locationIsRich() ? cleanHtml(incidence->location()) : incidence->location());
+        }
     }
 
     QString const durStr = durationString(incidence);
     if (!durStr.isEmpty()) {
-        tmp += QLatin1StringView("<br>");
-        tmp += QLatin1StringView("<i>") + i18n("Duration:") + QLatin1StringView("</i>") + QLatin1StringView("&nbsp;");
-        tmp += durStr;
+        html.lineBreak();
+        html.label(labels->duration);
+        html << durStr;
     }
 
     if (incidence->recurs()) {
-        tmp += QLatin1StringView("<br>");
-        tmp += QLatin1StringView("<i>") + i18n("Recurrence:") + QLatin1StringView("</i>") + QLatin1StringView("&nbsp;");
-        tmp += recurrenceString(incidence);
+        html.lineBreak();
+        html.label(labels->recurrence);
+        html << recurrenceString(incidence);
     }
 
     if (incidence->hasRecurrenceId()) {
-        tmp += QLatin1StringView("<br>");
-        tmp += QLatin1StringView("<i>") + i18n("Recurrence:") + QLatin1StringView("</i>") + QLatin1StringView("&nbsp;");
-        tmp += i18n("Exception");
+        html.lineBreak();
+        html.label(labels->recurrence);
+        html << labels->exception;
     }
 
     if (!incidence->description().isEmpty()) {
+        int const maxDescLen = 120; // maximum description chars to print (before ellipsis)
         QString desc(incidence->description());
-        if (!incidence->descriptionIsRich()) {
-            int const maxDescLen = 120; // maximum description chars to print (before ellipsis)
+        if (!mRichText) {
+            // Rich or not, the description may carry html tags (like "<p>whatever</p>")
+            desc = cleanHtml(desc);
+            if (desc.length() > maxDescLen) {
+                desc = desc.left(maxDescLen) + labels->ellipsis;
+            }
+        } else if (!incidence->descriptionIsRich()) {
             if (desc.length() > maxDescLen) {
-                desc = desc.left(maxDescLen) + i18nc("ellipsis", "...");
+                desc = desc.left(maxDescLen) + labels->ellipsis;
             }
             // cleanHtml first since non rich text might have html tags (like "<p>whatever</p>")
             desc = cleanHtml(desc).replace(u'\n', QLatin1StringView("<br>"));
         } else {
-            // TODO: truncate the description when it's rich text
+            desc = truncateRichText(desc, maxDescLen, labels->ellipsis);
         }
-        tmp += QLatin1StringView("<hr>");
-        tmp += QLatin1StringView("<i>") + i18n("Description:") + QLatin1StringView("</i>") + QLatin1StringView("<br>");
-        tmp += desc;
+        html.rule();
+        html.label(labels->description, true);
+        html << desc;
     }
 
     bool needAnHorizontalLine = true;
@@ -2764,44 +3189,47 @@ QString IncidenceFormatter::ToolTipVisitor::generateToolTip(const Incidence::Ptr
     if (reminderCount > 0 && incidence->hasEnabledAlarms()) {
         /* cppcheck-suppress knownConditionTrueFalse */
         if (needAnHorizontalLine) {
-            tmp += QLatin1StringView("<hr>");
+            html.rule();
             needAnHorizontalLine = false;
         } else {
-            tmp += QLatin1StringView("<br>");
+            html.lineBreak();
         }
-        tmp += QLatin1StringView("<i>") + i18np("Reminder:", "Reminders:", reminderCount) + QLatin1StringView("</i>") + QLatin1StringView("&nbsp;");
+        html.label(i18np("Reminder:", "Reminders:", reminderCount));
+        const QString lineBreak = mRichText ? QStringLiteral("<br>") : QStringLiteral("\n");
         if (reminderCount > 1) {
-            tmp += QLatin1StringView("<br> * ");
-            tmp += reminderStringList(incidence).join(QLatin1StringView("<br> * "));
+            html << lineBreak << QLatin1StringView(" * ") << reminderStringList(incidence).join(lineBreak + QLatin1StringView(" * "));
         } else {
-            tmp += reminderStringList(incidence).join(QLatin1StringView("<br>"));
+            html << reminderStringList(incidence).join(lineBreak);
         }
     }
 
-    const QString attendees = tooltipFormatAttendees(mCalendar, incidence);
-    if (!attendees.isEmpty()) {
-        if (needAnHorizontalLine) {
-            tmp += QLatin1StringView("<hr>");
-            needAnHorizontalLine = false;
-        } else {
-            tmp += QLatin1StringView("<br>");
-        }
-        tmp += attendees;
+    const qsizetype beforeAttendees = html.size();
+    if (needAnHorizontalLine) {
+        html.rule();
+    } else {
+        html.lineBreak();
+    }
+    if (tooltipFormatAttendees(html, *labels, mCalendar, incidence)) {
+        needAnHorizontalLine = false;
+    } else {
+        html.truncate(beforeAttendees);
     }
 
     int const categoryCount = incidence->categories().count();
     if (categoryCount > 0) {
         if (needAnHorizontalLine) {
-            tmp += QLatin1StringView("<hr>");
+            html.rule();
         } else {
-            tmp += QLatin1StringView("<br>");
+            html.lineBreak();
         }
-        tmp += QLatin1StringView("<i>") + i18np("Tag:", "Tags:", categoryCount) + QLatin1StringView("</i>") + QLatin1StringView("&nbsp;");
-        tmp += incidence->categories().join(QLatin1StringView(", "));
+        html.label(i18np("Tag:", "Tags:", categoryCount));
+        html << incidence->categories().join(QLatin1StringView(", "));
     }
 
-    tmp += QLatin1StringView("</qt>");
-    return tmp;
+    if (mRichText) {
+        html << QLatin1StringView("</qt>");
+    }
+    return html.take();
 }
 
 //@endcond
@@ -2823,15 +3251,17 @@ QString IncidenceFormatter::toolTipStr(const QString &sourceName, const Incidenc
 //@cond PRIVATE
 static QString mailBodyIncidence(const Incidence::Ptr &incidence)
 {
+    const std::shared_ptr<const FormatterLabels> labels = FormatterLabels::get();
+
     QString body;
     if (!incidence->summary().trimmed().isEmpty()) {
-        body += i18n("Summary: %1\n", incidence->richSummary());
+        body += labels->summaryLinePattern.arg(incidence->richSummary());
     }
     if (!incidence->organizer().isEmpty()) {
-        body += i18n("Organizer: %1\n", incidence->organizer().fullName());
+        body += labels->organizerLinePattern.arg(incidence->organizer().fullName());
     }
     if (!incidence->location().trimmed().isEmpty()) {
-        body += i18n("Location: %1\n", incidence->richLocation());
+        body += labels->locationLinePattern.arg(incidence->richLocation());
     }
     return body;
 }
@@ -3000,91 +3430,211 @@ QString IncidenceFormatter::mailBodyStr(const IncidenceBase::Ptr &incidence)
  *  More static formatting functions
  ************************************/
 
+//@cond PRIVATE
+namespace
+{
+struct RecurrenceStringCacheEntry {
+    QString text;
+    // The labels the text was built with, a different table means the locale changed
+    std::shared_ptr<const RecurrenceLabels> labels;
+};
+
+struct RecurrenceStringCache {
+    QMutex mutex;
+    QCache<QString, RecurrenceStringCacheEntry> entries{2048};
+    std::atomic<bool> enabled = false;
+};
+}
+
+Q_GLOBAL_STATIC(RecurrenceStringCache, sRecurrenceStringCache)
+
+[[nodiscard]] static QString recurrenceStringCacheKey(const Incidence::Ptr &incidence)
+{
+    return incidence->uid() + u'\x1f' + QString::number(incidence->revision()) + u'\x1f'
+        + QString::number(incidence->lastModified().toMSecsSinceEpoch());
+}
+
+static QString recurrenceStringHelper(const Incidence::Ptr &incidence, const RecurrenceLabels &labels);
+//@endcond
+
 QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
 {
     if (incidence->hasRecurrenceId()) {
         return QStringLiteral("Recurrence exception");
     }
 
+    const std::shared_ptr<const RecurrenceLabels> labels = RecurrenceLabels::get();
     if (!incidence->recurs()) {
-        return i18n("No recurrence");
-    }
-    static QStringList dayList;
-    if (dayList.isEmpty()) {
-        dayList.append(i18n("31st Last"));
-        dayList.append(i18n("30th Last"));
-        dayList.append(i18n("29th Last"));
-        dayList.append(i18n("28th Last"));
-        dayList.append(i18n("27th Last"));
-        dayList.append(i18n("26th Last"));
-        dayList.append(i18n("25th Last"));
-        dayList.append(i18n("24th Last"));
-        dayList.append(i18n("23rd Last"));
-        dayList.append(i18n("22nd Last"));
-        dayList.append(i18n("21st Last"));
-        dayList.append(i18n("20th Last"));
-        dayList.append(i18n("19th Last"));
-        dayList.append(i18n("18th Last"));
-        dayList.append(i18n("17th Last"));
-        dayList.append(i18n("16th Last"));
-        dayList.append(i18n("15th Last"));
-        dayList.append(i18n("14th Last"));
-        dayList.append(i18n("13th Last"));
-        dayList.append(i18n("12th Last"));
-        dayList.append(i18n("11th Last"));
-        dayList.append(i18n("10th Last"));
-        dayList.append(i18n("9th Last"));
-        dayList.append(i18n("8th Last"));
-        dayList.append(i18n("7th Last"));
-        dayList.append(i18n("6th Last"));
-        dayList.append(i18n("5th Last"));
-        dayList.append(i18n("4th Last"));
-        dayList.append(i18n("3rd Last"));
-        dayList.append(i18n("2nd Last"));
-        dayList.append(i18nc("last day of the month", "Last"));
-        dayList.append(i18nc("unknown day of the month", "unknown")); // #31 - zero offset from UI
-        dayList.append(i18n("1st"));
-        dayList.append(i18n("2nd"));
-        dayList.append(i18n("3rd"));
-        dayList.append(i18n("4th"));
-        dayList.append(i18n("5th"));
-        dayList.append(i18n("6th"));
-        dayList.append(i18n("7th"));
-        dayList.append(i18n("8th"));
-        dayList.append(i18n("9th"));
-        dayList.append(i18n("10th"));
-        dayList.append(i18n("11th"));
-        dayList.append(i18n("12th"));
-        dayList.append(i18n("13th"));
-        dayList.append(i18n("14th"));
-        dayList.append(i18n("15th"));
-        dayList.append(i18n("16th"));
-        dayList.append(i18n("17th"));
-        dayList.append(i18n("18th"));
-        dayList.append(i18n("19th"));
-        dayList.append(i18n("20th"));
-        dayList.append(i18n("21st"));
-        dayList.append(i18n("22nd"));
-        dayList.append(i18n("23rd"));
-        dayList.append(i18n("24th"));
-        dayList.append(i18n("25th"));
-        dayList.append(i18n("26th"));
-        dayList.append(i18n("27th"));
-        dayList.append(i18n("28th"));
-        dayList.append(i18n("29th"));
-        dayList.append(i18n("30th"));
-        dayList.append(i18n("31st"));
+        return labels->noRecurrence;
+    }
+
+    RecurrenceStringCache *const cache = sRecurrenceStringCache();
+    if (!cache->enabled.load(std::memory_order_relaxed)) {
+        return recurrenceStringHelper(incidence, *labels);
+    }
+
+    const QString key = recurrenceStringCacheKey(incidence);
+    {
+        const QMutexLocker locker(&cache->mutex);
+        const RecurrenceStringCacheEntry *entry = cache->entries.object(key);
+        if (entry && entry->labels == labels) {
+            return entry->text;
+        }
+    }
+
+    const QString text = recurrenceStringHelper(incidence, *labels);
+
+    const QMutexLocker locker(&cache->mutex);
+    cache->entries.insert(key, new RecurrenceStringCacheEntry{text, labels});
+    return text;
+}
+
+void IncidenceFormatter::setRecurrenceStringCacheEnabled(bool enabled)
+{
+    RecurrenceStringCache *const cache = sRecurrenceStringCache();
+    cache->enabled.store(enabled);
+    if (!enabled) {
+        clearRecurrenceStringCache();
+    }
+}
+
+void IncidenceFormatter::clearRecurrenceStringCache()
+{
+    RecurrenceStringCache *const cache = sRecurrenceStringCache();
+    const QMutexLocker locker(&cache->mutex);
+    cache->entries.clear();
+}
+
+void IncidenceFormatter::clearOccurrenceCache()
+{
+    OccurrenceCache::clear();
+}
+
+//@cond PRIVATE
+namespace
+{
+/*
+ * Collects the distinct excluded dates of a recurrence for recurrenceString().
+ * Dates are deduplicated on the value shown for the recurrence type (minute,
+ * time, year or date) before they are formatted, and formatting stops once
+ * the maximum number of entries has been collected.
+ */
+class ExceptionSummary
+{
+public:
+    ExceptionSummary(ushort recurrenceType, int maxEntries)
+        : mRecurrenceType(recurrenceType)
+        , mMaxEntries(maxEntries)
+    {
+        mEntries.reserve(maxEntries);
+    }
+
+    [[nodiscard]] bool isFull() const
+    {
+        return mEntries.size() >= mMaxEntries;
+    }
+
+    [[nodiscard]] bool isEmpty() const
+    {
+        return mEntries.isEmpty();
+    }
+
+    void addDateTime(const QDateTime &dt)
+    {
+        switch (mRecurrenceType) {
+        case Recurrence::rMinutely:
+            if (isNew(dt.time().minute())) {
+                mEntries.append(i18n("minute %1", dt.time().minute()));
+            }
+            break;
+        case Recurrence::rHourly:
+            // shown with minute precision
+            if (isNew(dt.time().msecsSinceStartOfDay() / 60000)) {
+                mEntries.append(mLocale.toString(dt.time(), QLocale::ShortFormat));
+            }
+            break;
+        case Recurrence::rYearlyMonth:
+            addYear(dt.date().year());
+            break;
+        case Recurrence::rWeekly:
+        case Recurrence::rDaily:
+        case Recurrence::rMonthlyPos:
+        case Recurrence::rMonthlyDay:
+        case Recurrence::rYearlyDay:
+        case Recurrence::rYearlyPos:
+            addDate(dt.date());
+            break;
+        default:
+            break;
+        }
+    }
+
+    void addDate(QDate date)
+    {
+        switch (mRecurrenceType) {
+        case Recurrence::rYearlyMonth:
+            addYear(date.year());
+            break;
+        case Recurrence::rWeekly:
+        case Recurrence::rDaily:
+        case Recurrence::rMonthlyPos:
+        case Recurrence::rMonthlyDay:
+        case Recurrence::rYearlyDay:
+        case Recurrence::rYearlyPos:
+            if (isNew(date.toJulianDay())) {
+                mEntries.append(mLocale.toString(date, QLocale::ShortFormat));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void addText(const QString &text)
+    {
+        mEntries.append(text);
+    }
+
+    [[nodiscard]] QString result() const
+    {
+        return mEntries.join(u',');
+    }
+
+private:
+    void addYear(int year)
+    {
+        if (isNew(year)) {
+            mEntries.append(QString::number(year));
+        }
     }
 
+    [[nodiscard]] bool isNew(qint64 key)
+    {
+        const qsizetype size = mSeen.size();
+        mSeen.insert(key);
+        return mSeen.size() != size;
+    }
+
+    const ushort mRecurrenceType;
+    const qsizetype mMaxEntries;
+    const QLocale mLocale;
+    QSet<qint64> mSeen;
+    QStringList mEntries;
+};
+}
+
+static QString recurrenceStringHelper(const Incidence::Ptr &incidence, const RecurrenceLabels &labels)
+{
+    const QStringList &dayList = labels.dayList;
+
     const int weekStart = QLocale().firstDayOfWeek();
 
     Recurrence const *recur = incidence->recurrence();
 
     QString recurStr;
-    static QString const noRecurrence = i18n("No recurrence");
     switch (recur->recurrenceType()) {
     case Recurrence::rNone:
-        return noRecurrence;
+        return labels.noRecurrence;
 
     case Recurrence::rMinutely:
         if (recur->duration() != -1) {
@@ -3125,14 +3675,14 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
         for (int i = 0; i < 7; ++i) {
             if (recur->days().testBit((i + weekStart + 6) % 7)) {
                 if (addSpace) {
-                    dayNames.append(i18nc("separator for list of days", ", "));
+                    dayNames.append(labels.daySeparator);
                 }
-                dayNames.append(QLocale().dayName(((i + weekStart + 6) % 7) + 1, QLocale::ShortFormat));
+                dayNames.append(labels.shortDayName(((i + weekStart + 6) % 7) + 1));
                 addSpace = true;
             }
         }
         if (dayNames.isEmpty()) {
-            dayNames = i18nc("Recurs weekly on no days", "no days");
+            dayNames = labels.noDays;
         }
         if (recur->duration() != -1) {
             recurStr = i18ncp("Recurs weekly on [list of days] until end-date",
@@ -3160,7 +3710,7 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
                     "Recurs every %1 months on the %2 %3 until %4",
                     recur->frequency(),
                     dayList[rule.pos() + 31],
-                    QLocale().dayName(rule.day(), QLocale::LongFormat),
+                    labels.longDayName(rule.day()),
                     recurEnd(incidence));
                 if (recur->duration() > 0) {
                     recurStr += xi18nc("number of occurrences", " (%1 occurrences)", recur->duration());
@@ -3171,7 +3721,7 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
                                   "Recurs every %1 months on the %2 %3",
                                   recur->frequency(),
                                   dayList[rule.pos() + 31],
-                                  QLocale().dayName(rule.day(), QLocale::LongFormat));
+                                  labels.longDayName(rule.day()));
             }
         }
         break;
@@ -3206,7 +3756,7 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
                     "Recurs yearly on %2 %3 until %4",
                     "Recurs every %1 years on %2 %3 until %4",
                     recur->frequency(),
-                    QLocale().monthName(recur->yearMonths().at(0), QLocale::LongFormat),
+                    labels.longMonthName(recur->yearMonths().at(0)),
                     dayList.at(recur->yearDates().at(0) + 31),
                     recurEnd(incidence));
                 if (recur->duration() > 0) {
@@ -3219,18 +3769,18 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
                                   "Recurs yearly on %2 %3",
                                   "Recurs every %1 years on %2 %3",
                                   recur->frequency(),
-                                  QLocale().monthName(recur->yearMonths().at(0), QLocale::LongFormat),
+                                  labels.longMonthName(recur->yearMonths().at(0)),
                                   dayList[recur->yearDates().at(0) + 31]);
             } else {
                 if (!recur->yearMonths().isEmpty()) {
                     recurStr = i18nc("Recurs Every year on month-name [1st|2nd|...]",
                                      "Recurs yearly on %1 %2",
-                                     QLocale().monthName(recur->yearMonths().at(0), QLocale::LongFormat),
+                                     labels.longMonthName(recur->yearMonths().at(0)),
                                      dayList[recur->startDate().day() + 31]);
                 } else {
                     recurStr = i18nc("Recurs Every year on month-name [1st|2nd|...]",
                                      "Recurs yearly on %1 %2",
-                                     QLocale().monthName(recur->startDate().month(), QLocale::LongFormat),
+                                     labels.longMonthName(recur->startDate().month()),
                                      dayList[recur->startDate().day() + 31]);
                 }
             }
@@ -3271,8 +3821,8 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
                     " until %5",
                     recur->frequency(),
                     dayList[rule.pos() + 31],
-                    QLocale().dayName(rule.day(), QLocale::LongFormat),
-                    QLocale().monthName(recur->yearMonths().at(0), QLocale::LongFormat),
+                    labels.longDayName(rule.day()),
+                    labels.longMonthName(recur->yearMonths().at(0)),
                     recurEnd(incidence));
                 if (recur->duration() > 0) {
                     recurStr += i18nc("number of occurrences", " (%1 occurrences)", recur->duration());
@@ -3285,8 +3835,8 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
                     "Every %1 years on the %2 %3 of %4",
                     recur->frequency(),
                     dayList[rule.pos() + 31],
-                    QLocale().dayName(rule.day(), QLocale::LongFormat),
-                    QLocale().monthName(recur->yearMonths().at(0), QLocale::LongFormat));
+                    labels.longDayName(rule.day()),
+                    labels.longMonthName(recur->yearMonths().at(0)));
             }
         }
         break;
@@ -3300,86 +3850,26 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
 
     // Now, append the EXDATEs
     const auto exDtList = recur->exDateTimes();
+    DateList const exDList = recur->exDates();
     static int const maxExDates = 7; // only print so many exceptions; after all, this is for tooltips and display purposes
-    int count = 0;
-    QStringList seen;
-    QStringList exStrList;
-    for (auto il = exDtList.cbegin(), end = exDtList.cend(); count < maxExDates && il != end; ++il) {
-        QString exDt;
-        switch (recur->recurrenceType()) {
-        case Recurrence::rMinutely:
-            exDt = i18n("minute %1", (*il).time().minute());
-            break;
-        case Recurrence::rHourly:
-            exDt = QLocale().toString((*il).time(), QLocale::ShortFormat);
-            break;
-        case Recurrence::rWeekly:
-            // exDt = QLocale().dayName((*il).date().dayOfWeek(), QLocale::ShortFormat);
-            exDt = QLocale().toString((*il).date(), QLocale::ShortFormat);
-            break;
-        case Recurrence::rYearlyMonth:
-            exDt = QString::number((*il).date().year());
-            break;
-        case Recurrence::rDaily:
-        case Recurrence::rMonthlyPos:
-        case Recurrence::rMonthlyDay:
-        case Recurrence::rYearlyDay:
-        case Recurrence::rYearlyPos:
-            exDt = QLocale().toString((*il).date(), QLocale::ShortFormat);
-            break;
-        default: // make clang-tidy happy
-            break;
-        }
-        if (!seen.contains(exDt)) {
-            count++;
-            seen << exDt;
-            exStrList << exDt;
-        }
-    }
 
-    DateList const exDList = recur->exDates();
-    DateList::ConstIterator dl;
-    const DateList::ConstIterator dlEnd(exDList.constEnd());
-    for (dl = exDList.constBegin(); count < maxExDates && dl != dlEnd; ++dl) {
-        QString exDt;
-        switch (recur->recurrenceType()) {
-        case Recurrence::rDaily:
-            exDt = QLocale().toString((*dl), QLocale::ShortFormat);
-            break;
-        case Recurrence::rWeekly:
-            // exStrList << calSys->weekDayName( (*dl), KCalendarSystem::ShortDayName );
-            // kolab/issue4735, should be ( excluding 3 days ), instead of excluding( Fr,Fr,Fr )
-            if (exStrList.isEmpty()) {
-                exDt = i18np("1 day", "%1 days", recur->exDates().count());
-            }
-            break;
-        case Recurrence::rMonthlyPos: // NOLINT(bugprone-branch-clone)
-            exDt = QLocale().toString((*dl), QLocale::ShortFormat);
-            break;
-        case Recurrence::rMonthlyDay:
-            exDt = QLocale().toString((*dl), QLocale::ShortFormat);
-            break;
-        case Recurrence::rYearlyMonth:
-            exDt = QString::number((*dl).year());
-            break;
-        case Recurrence::rYearlyDay: // NOLINT(bugprone-branch-clone)
-            exDt = QLocale().toString((*dl), QLocale::ShortFormat);
-            break;
-        case Recurrence::rYearlyPos:
-            exDt = QLocale().toString((*dl), QLocale::ShortFormat);
-            break;
-        default: // make clang-tidy happy
-            break;
+    ExceptionSummary summary(recur->recurrenceType(), maxExDates);
+    for (auto il = exDtList.cbegin(), end = exDtList.cend(); !summary.isFull() && il != end; ++il) {
+        summary.addDateTime(*il);
+    }
+    if (recur->recurrenceType() == Recurrence::rWeekly) {
+        // kolab/issue4735, should be ( excluding 3 days ), instead of excluding( Fr,Fr,Fr )
+        if (summary.isEmpty() && !exDList.isEmpty()) {
+            summary.addText(i18np("1 day", "%1 days", exDList.count()));
         }
-        if (!seen.contains(exDt)) {
-            count++;
-            seen << exDt;
-            exStrList << exDt;
+    } else {
+        for (auto dl = exDList.cbegin(), end = exDList.cend(); !summary.isFull() && dl != end; ++dl) {
+            summary.addDate(*dl);
         }
     }
 
-    if (!exStrList.isEmpty()) {
-        QString exStr = exStrList.join(u',');
+    if (!summary.isEmpty()) {
+        QString exStr = summary.result();
         if ((exDtList.count() + exDList.count()) > maxExDates) {
             exStr = exStr + i18nc("ellipsis", "...");
         }
@@ -3388,6 +3878,7 @@ QString IncidenceFormatter::recurrenceString(const Incidence::Ptr &incidence)
 
     return recurStr;
 }
+//@endcond
 
 QString IncidenceFormatter::dateTimeToString(const QDateTime &date, bool allDay, bool shortfmt)
 {
@@ -3460,6 +3951,7 @@ QStringList IncidenceFormatter::reminderStringList(const Incidence::Ptr &inciden
     QStringList reminderStringList;
 
     if (incidence) {
+        const std::shared_ptr<const FormatterLabels> labels = FormatterLabels::get();
         Alarm::List const alarms = incidence->alarms();
         Alarm::List::ConstIterator it;
         const Alarm::List::ConstIterator end(alarms.constEnd());
@@ -3479,9 +3971,9 @@ QStringList IncidenceFormatter::reminderStringList(const Incidence::Ptr &inciden
                 offset = alarm->startOffset().asSeconds();
                 if (offset < 0) {
                     offset = -offset;
-                    offsetStr = i18nc("N days/hours/minutes before the start datetime", "%1 before the start", secs2Duration(offset));
+                    offsetStr = labels->beforeStartPattern.arg(secs2Duration(offset));
                 } else if (offset > 0) {
-                    offsetStr = i18nc("N days/hours/minutes after the start datetime", "%1 after the start", secs2Duration(offset));
+                    offsetStr = labels->afterStartPattern.arg(secs2Duration(offset));
                 } else { // offset is 0
                     if (incidence->dtStart().isValid()) {
                         atStr = QLocale().toString(incidence->dtStart().toLocalTime(), QLocale::ShortFormat);
@@ -3492,15 +3984,15 @@ QStringList IncidenceFormatter::reminderStringList(const Incidence::Ptr &inciden
                 if (offset < 0) {
                     offset = -offset;
                     if (incidence->type() == Incidence::TypeTodo) {
-                        offsetStr = i18nc("N days/hours/minutes before the due datetime", "%1 before the to-do is due", secs2Duration(offset));
+                        offsetStr = labels->beforeDuePattern.arg(secs2Duration(offset));
                     } else {
-                        offsetStr = i18nc("N days/hours/minutes before the end datetime", "%1 before the end", secs2Duration(offset));
+                        offsetStr = labels->beforeEndPattern.arg(secs2Duration(offset));
                     }
                 } else if (offset > 0) {
                     if (incidence->type() == Incidence::TypeTodo) {
-                        offsetStr = i18nc("N days/hours/minutes after the due datetime", "%1 after the to-do is due", secs2Duration(offset));
+                        offsetStr = labels->afterDuePattern.arg(secs2Duration(offset));
                     } else {
-                        offsetStr = i18nc("N days/hours/minutes after the end datetime", "%1 after the end", secs2Duration(offset));
+                        offsetStr = labels->afterEndPattern.arg(secs2Duration(offset));
                     }
                 } else { // offset is 0
                     if (incidence->type() == Incidence::TypeTodo) {
@@ -3518,7 +4010,7 @@ QStringList IncidenceFormatter::reminderStringList(const Incidence::Ptr &inciden
             }
             if (offset == 0) {
                 if (!atStr.isEmpty()) {
-                    remStr = i18nc("reminder occurs at datetime", "at %1", atStr);
+                    remStr = labels->atPattern.arg(atStr);
                 }
             } else {
                 remStr = offsetStr;
@@ -3526,13 +4018,13 @@ QStringList IncidenceFormatter::reminderStringList(const Incidence::Ptr &inciden
 
             if (alarm->repeatCount() > 0) {
                 QString const countStr = i18np("repeats once", "repeats %1 times", alarm->repeatCount());
-                QString const intervalStr = i18nc("interval is N days/hours/minutes", "interval is %1", secs2Duration(alarm->snoozeTime().asSeconds()));
+                QString const intervalStr = labels->intervalPattern.arg(secs2Duration(alarm->snoozeTime().asSeconds()));
                 QString repeatStr = i18nc("(repeat string, interval string)", "(%1, %2)", countStr, intervalStr);
                 remStr = remStr + u' ' + repeatStr;
             }
             QStringList types;
             if (!alarm->enabled()) {
-                types << i18nc("alarm is disabled", "disabled");
+                types << labels->alarmDisabled;
             }
             // FYI: we no longer support email or procedure alarms. and no need to pollute the output with "display"
             if (alarm->type() == KCalendarCore::Alarm::Audio) {
@@ -24,9 +24,13 @@
 #include <KCalendarCore/Incidence>
 
 #include <QDate>
+#include <QFuture>
+#include <QVariantHash>
 
 #include <memory>
 
+class QThreadPool;
+
 namespace KCalUtils
 {
 class InvitationFormatterHelperPrivate;
@@ -69,6 +73,7 @@ public:
     [[nodiscard]] virtual KCalendarCore::Calendar::Ptr calendar() const;
 
 private:
+    friend class InvitationFormatterHelperPrivate;
     Q_DISABLE_COPY(InvitationFormatterHelper)
     std::unique_ptr<InvitationFormatterHelperPrivate> const d;
 };
@@ -125,6 +130,60 @@ KCALUTILS_EXPORT QString extensiveDisplayStr(const KCalendarCore::Calendar::Ptr
 */
 KCALUTILS_EXPORT QString extensiveDisplayStr(const QString &sourceName, const KCalendarCore::IncidenceBase::Ptr &incidence, QDate date = QDate());
 
+/*!
+  \enum IncidenceFormatter::DisplaySection
+
+  The parts of the extensiveDisplayStr() of an event or a to-do that
+  extensiveDisplaySection() can render on their own.
+
+  \value AttendeesSection
+         The organizer and the attendees rows, with their participation status.
+
+  \since 6.9
+*/
+enum DisplaySection {
+    AttendeesSection,
+};
+
+/*!
+  Create the RichText QString representation of one \a section of the
+  extensiveDisplayStr() of an event or a to-do, e.g. to update only the
+  attendees of a meeting in a viewer widget as replies come in, instead of
+  formatting the whole incidence again.
+
+  The result is the same markup as the section has in extensiveDisplayStr(),
+  that is rows of its details table.
+
+  \param calendar a pointer to the Calendar that owns the incidence.
+  \param incidence a pointer to the event or to-do to be formatted.
+  \param section the section to format.
+  \return the formatted section, or an empty string for other incidence types
+
+  \since 6.9
+*/
+KCALUTILS_EXPORT QString extensiveDisplaySection(const KCalendarCore::Calendar::Ptr &calendar,
+                                                 const KCalendarCore::IncidenceBase::Ptr &incidence,
+                                                 DisplaySection section);
+
+/*!
+  Create the extensiveDisplayStr() of each of \a incidences, e.g. to print or
+  export a whole agenda. The incidences are formatted concurrently on a
+  thread pool, the calendar must not be modified meanwhile.
+
+  \param calendar a pointer to the Calendar that owns the incidences.
+  \param incidences the incidences to format.
+  \param date the QDate for which the string representations should be computed;
+  used mainly for recurring incidences.
+  \param pool the thread pool to format on, the global thread pool if null.
+  \return the formatted strings, in the order of \a incidences
+
+  \since 6.9
+*/
+KCALUTILS_EXPORT QStringList extensiveDisplayStrs(const KCalendarCore::Calendar::Ptr &calendar,
+                                                  const KCalendarCore::Incidence::List &incidences,
+                                                  QDate date = QDate(),
+                                                  QThreadPool *pool = nullptr);
+
 /*!
   Create a QString representation of an Incidence in format suitable for
   including inside a mail message.
@@ -168,6 +227,99 @@ KCALUTILS_EXPORT QString formatICalInvitationNoHtml(const QString &invitation,
                                                     InvitationFormatterHelper *helper,
                                                     const QString &sender);
 
+/*!
+  Deliver the model formatICalInvitation() renders its HTML from, for
+  consumers rendering invitations in their own format, e.g. as JSON.
+
+  The model holds the same keys the itip_*.html templates use: the
+  \c type of the incidence ("event", "todo", "journal" or "freebusy"),
+  \c head, \c eventInfo, \c myStatus, \c buttons, \c attendees,
+  \c attachments and the details of the incidence such as \c summary,
+  \c location or \c dateTime. Text values are HTML unless \a noHtmlMode
+  is set, links are built through \a helper.
+
+  \param invitation a QString containing a string representation of a calendar Incidence
+  which will be interpreted as an invitation.
+  \param calendar a pointer to the Calendar that owns the invitation.
+  \param helper a pointer to an InvitationFormatterHelper.
+  \param noHtmlMode if true, the invitation details have their HTML formatting cleaned.
+  \param sender the email address of the person sending the invitation, used in \a noHtmlMode.
+  \return the invitation model, empty if the invitation could not be parsed
+
+  \sa renderICalInvitationModel()
+  \since 6.9
+*/
+KCALUTILS_EXPORT QVariantHash formatICalInvitationModel(const QString &invitation,
+                                                        const KCalendarCore::Calendar::Ptr &calendar,
+                                                        InvitationFormatterHelper *helper,
+                                                        bool noHtmlMode = false,
+                                                        const QString &sender = QString());
+
+/*!
+  Render a model returned by formatICalInvitationModel() to HTML.
+  formatICalInvitation() is formatICalInvitationModel() followed by this.
+
+  \param model the invitation model
+  \return the formatted HTML invitation string, empty for an empty model or
+  one whose \c type is not \c event, \c todo, \c journal or \c freebusy
+
+  \since 6.9
+*/
+KCALUTILS_EXPORT QString renderICalInvitationModel(const QVariantHash &model);
+
+/*!
+  Deliver HTML formatted strings for a list of invitations, all displayed
+  against the same calendar, e.g. when indexing a whole mailbox.
+  Produces the same output as calling formatICalInvitation() for each
+  invitation, but the calendar of \a helper is indexed only once.
+
+  \param invitations the string representations of the invitations.
+  \param calendar a pointer to the Calendar that owns the invitations.
+  \param helper a pointer to an InvitationFormatterHelper.
+  \param parallel if true, the invitations are formatted concurrently on
+  \a pool. \a helper must then be safe to use from several threads.
+  \param pool the thread pool to format on when \a parallel, the global thread pool if null.
+  \return the formatted HTML invitation strings, in the order of \a invitations
+
+  \since 6.9
+*/
+KCALUTILS_EXPORT QStringList formatICalInvitations(const QStringList &invitations,
+                                                   const KCalendarCore::Calendar::Ptr &calendar,
+                                                   InvitationFormatterHelper *helper,
+                                                   bool parallel = false,
+                                                   QThreadPool *pool = nullptr);
+
+/*!
+  Deliver the HTML formatted string displaying an invitation without blocking
+  the caller. The invitation is parsed, compared to the calendar of \a helper
+  and rendered on a thread pool.
+
+  Canceling the returned future, e.g. when the invitation is scrolled out of
+  view, makes the render stop at its next stage; a canceled future carries no
+  result. \a helper is only used before this returns: the links and the
+  calendar the render needs are taken from it, so it may be deleted while the
+  render is pending. The links of the attachments depend on their labels, the
+  invitation is therefore parsed once in the calling thread as well. The calendars are read from the worker thread: cancel
+  pending renders and wait for them before modifying them.
+
+  \param invitation a QString containing a string representation of a calendar Incidence
+  which will be interpreted as an invitation.
+  \param calendar a pointer to the Calendar that owns the invitation.
+  \param helper a pointer to an InvitationFormatterHelper.
+  \param noHtmlMode if true, behaves as formatICalInvitationNoHtml(), else as formatICalInvitation().
+  \param sender the email address of the person sending the invitation, used in \a noHtmlMode.
+  \param pool the thread pool to render on, the global thread pool if null.
+  \return a future reporting the formatted HTML invitation string
+
+  \since 6.9
+*/
+KCALUTILS_EXPORT QFuture<QString> formatICalInvitationAsync(const QString &invitation,
+                                                            const KCalendarCore::Calendar::Ptr &calendar,
+                                                            InvitationFormatterHelper *helper,
+                                                            bool noHtmlMode = false,
+                                                            const QString &sender = QString(),
+                                                            QThreadPool *pool = nullptr);
+
 /*!
   Build a pretty QString representation of an Incidence's recurrence info.
   \param incidence a pointer to the Incidence whose recurrence info is to be formatted
@@ -175,6 +327,33 @@ KCALUTILS_EXPORT QString formatICalInvitationNoHtml(const QString &invitation,
 */
 KCALUTILS_EXPORT QString recurrenceString(const KCalendarCore::Incidence::Ptr &incidence);
 
+/*!
+  Enable or disable memoization of recurrenceString().
+  When enabled, the string built for an incidence is reused as long as its
+  UID, revision and last modification time as well as the application
+  language and locale are unchanged. Applications that change the recurrence
+  of an incidence without updating its revision or last modification time
+  should call clearRecurrenceStringCache(). Disabled by default.
+
+  \param enabled whether recurrenceString() may return cached strings
+  \since 6.9
+*/
+KCALUTILS_EXPORT void setRecurrenceStringCacheEnabled(bool enabled);
+
+/*!
+  Drop all strings memoized by recurrenceString().
+  \since 6.9
+*/
+KCALUTILS_EXPORT void clearRecurrenceStringCache();
+
+/*!
+  Drop all recurrence expansions cached for the formatters and for
+  RecurrenceActions, e.g. to release their memory. Cached expansions are
+  never stale, they are dropped once the incidence or its recurrence changes.
+  \since 6.9
+*/
+KCALUTILS_EXPORT void clearOccurrenceCache();
+
 /*!
   Returns a reminder string list computed for the specified Incidence.
   Each item of the returning QStringList corresponds to a string
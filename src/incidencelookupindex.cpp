@@ -0,0 +1,130 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "incidencelookupindex_p.h"
+
+#include <QMutexLocker>
+
+using namespace KCalUtils;
+using namespace KCalendarCore;
+
+IncidenceLookupIndex::IncidenceLookupIndex(const Calendar::Ptr &calendar)
+{
+    attach(calendar);
+}
+
+IncidenceLookupIndex::~IncidenceLookupIndex()
+{
+    detach();
+}
+
+void IncidenceLookupIndex::attach(const Calendar::Ptr &calendar)
+{
+    const QMutexLocker locker(&mMutex);
+    if (calendar && mCalendar.toStrongRef() == calendar) {
+        return;
+    }
+
+    reset();
+    if (!calendar) {
+        return;
+    }
+
+    mCalendar = calendar;
+    const Incidence::List incidences = calendar->incidences();
+    mIncidences.reserve(incidences.size());
+    mKeys.reserve(incidences.size());
+    for (const Incidence::Ptr &incidence : incidences) {
+        insert(incidence);
+    }
+    calendar->registerObserver(this);
+}
+
+void IncidenceLookupIndex::detach()
+{
+    const QMutexLocker locker(&mMutex);
+    reset();
+}
+
+void IncidenceLookupIndex::reset()
+{
+    // The calendar may already be gone, it then no longer knows about us either
+    if (const Calendar::Ptr calendar = mCalendar.toStrongRef()) {
+        calendar->unregisterObserver(this);
+    }
+    mCalendar.clear();
+    mIncidences.clear();
+    mKeys.clear();
+}
+
+bool IncidenceLookupIndex::isAttachedTo(const Calendar::Ptr &calendar) const
+{
+    const QMutexLocker locker(&mMutex);
+    return mCalendar.toStrongRef() == calendar;
+}
+
+Incidence::List IncidenceLookupIndex::find(const QString &schedulingId, const QDateTime &recurrenceId) const
+{
+    const QMutexLocker locker(&mMutex);
+    return mIncidences.value(Key(schedulingId, recurrenceId));
+}
+
+qsizetype IncidenceLookupIndex::size() const
+{
+    const QMutexLocker locker(&mMutex);
+    return mKeys.size();
+}
+
+void IncidenceLookupIndex::calendarIncidenceAdded(const Incidence::Ptr &incidence)
+{
+    const QMutexLocker locker(&mMutex);
+    insert(incidence);
+}
+
+void IncidenceLookupIndex::calendarIncidenceChanged(const Incidence::Ptr &incidence)
+{
+    const QMutexLocker locker(&mMutex);
+    const Key key(incidence->schedulingID(), incidence->recurrenceId());
+    if (mKeys.value(incidence.data()) != key) {
+        remove(incidence);
+        insert(incidence);
+    }
+}
+
+void IncidenceLookupIndex::calendarIncidenceDeleted(const Incidence::Ptr &incidence, [[maybe_unused]] const Calendar *calendar)
+{
+    const QMutexLocker locker(&mMutex);
+    remove(incidence);
+}
+
+void IncidenceLookupIndex::insert(const Incidence::Ptr &incidence)
+{
+    if (!incidence || mKeys.contains(incidence.data())) {
+        return;
+    }
+    const Key key(incidence->schedulingID(), incidence->recurrenceId());
+    mIncidences[key].append(incidence);
+    mKeys.insert(incidence.data(), key);
+}
+
+void IncidenceLookupIndex::remove(const Incidence::Ptr &incidence)
+{
+    const auto keyIt = mKeys.constFind(incidence.data());
+    if (keyIt == mKeys.cend()) {
+        return;
+    }
+
+    const auto it = mIncidences.find(*keyIt);
+    if (it != mIncidences.end()) {
+        it->removeOne(incidence);
+        if (it->isEmpty()) {
+            mIncidences.erase(it);
+        }
+    }
+    mKeys.erase(keyIt);
+}
@@ -0,0 +1,77 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kcalutils_private_export.h"
+
+#include <KCalendarCore/Calendar>
+#include <KCalendarCore/Incidence>
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QWeakPointer>
+
+namespace KCalUtils
+{
+/*
+ * Maps (schedulingID, recurrenceId) to the incidences of a calendar, so that
+ * the incidence an invitation refers to can be found without scanning the
+ * whole calendar.
+ *
+ * Once attached, the index observes the calendar and follows additions,
+ * changes and removals of incidences. All members lock the index, so that
+ * lookups from other threads are safe while the calendar notifies changes.
+ */
+class KCALUTILS_TESTS_EXPORT IncidenceLookupIndex : public KCalendarCore::Calendar::CalendarObserver
+{
+public:
+    IncidenceLookupIndex() = default;
+    explicit IncidenceLookupIndex(const KCalendarCore::Calendar::Ptr &calendar);
+    ~IncidenceLookupIndex() override;
+
+    /*
+     * Indexes @p calendar and keeps the index up to date until another
+     * calendar is attached. Does nothing when @p calendar is already attached.
+     */
+    void attach(const KCalendarCore::Calendar::Ptr &calendar);
+    void detach();
+    [[nodiscard]] bool isAttachedTo(const KCalendarCore::Calendar::Ptr &calendar) const;
+
+    /*
+     * Returns all incidences indexed under @p schedulingId and @p recurrenceId,
+     * in the order they were registered. Several incidences share a key when
+     * copies of the same invitation live in different folders, callers pick
+     * the one they are interested in.
+     */
+    [[nodiscard]] KCalendarCore::Incidence::List find(const QString &schedulingId, const QDateTime &recurrenceId) const;
+    [[nodiscard]] qsizetype size() const;
+
+protected:
+    void calendarIncidenceAdded(const KCalendarCore::Incidence::Ptr &incidence) override;
+    void calendarIncidenceChanged(const KCalendarCore::Incidence::Ptr &incidence) override;
+    void calendarIncidenceDeleted(const KCalendarCore::Incidence::Ptr &incidence, const KCalendarCore::Calendar *calendar) override;
+
+private:
+    Q_DISABLE_COPY(IncidenceLookupIndex)
+    using Key = std::pair<QString, QDateTime>;
+
+    // Expect mMutex to be locked
+    void reset();
+    void insert(const KCalendarCore::Incidence::Ptr &incidence);
+    void remove(const KCalendarCore::Incidence::Ptr &incidence);
+
+    mutable QMutex mMutex;
+    QWeakPointer<KCalendarCore::Calendar> mCalendar;
+    QHash<Key, KCalendarCore::Incidence::List> mIncidences;
+    // The key each incidence was indexed under, its scheduling ID may change afterwards
+    QHash<const KCalendarCore::Incidence *, Key> mKeys;
+};
+}
@@ -0,0 +1,57 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <KLocalizedString>
+
+#include <QLocale>
+#include <QMutex>
+#include <QStringList>
+
+#include <memory>
+
+namespace KCalUtils
+{
+/*
+ * Holds one instance of T, a table of translated strings, for the current
+ * application languages and QLocale. The table is rebuilt on first use after
+ * either of them changed. Safe to use from several threads; callers keep the
+ * returned table alive while using it, even if another thread replaces it.
+ */
+template<typename T>
+class LocaleCache
+{
+public:
+    [[nodiscard]] std::shared_ptr<const T> get()
+    {
+        const QStringList languages = KLocalizedString::languages();
+        const QLocale locale;
+
+        const QMutexLocker locker(&mMutex);
+        if (!mValue || mLanguages != languages || mLocale != locale) {
+            mValue = std::make_shared<const T>();
+            mLanguages = languages;
+            mLocale = locale;
+        }
+        return mValue;
+    }
+
+    void clear()
+    {
+        const QMutexLocker locker(&mMutex);
+        mValue.reset();
+    }
+
+private:
+    QMutex mMutex;
+    std::shared_ptr<const T> mValue;
+    QStringList mLanguages;
+    QLocale mLocale;
+};
+}
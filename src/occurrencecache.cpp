@@ -0,0 +1,198 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "occurrencecache_p.h"
+
+#include <KCalendarCore/Recurrence>
+#include <KCalendarCore/RecurrenceRule>
+
+#include <QCache>
+#include <QMutex>
+#include <QWeakPointer>
+
+#include <optional>
+
+using namespace KCalUtils;
+using namespace KCalendarCore;
+
+namespace
+{
+enum class Query : quint8 {
+    TimesInInterval,
+    PreviousDateTime,
+    NextDateTime,
+    StartDateTimesForDate,
+};
+
+struct Key {
+    const Incidence *incidence = nullptr;
+    Query query = Query::TimesInInterval;
+    qint64 from = 0;
+    qint64 to = 0;
+    QByteArray timeZone;
+
+    bool operator==(const Key &other) const
+    {
+        return incidence == other.incidence && query == other.query && from == other.from && to == other.to && timeZone == other.timeZone;
+    }
+};
+
+size_t qHash(const Key &key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.incidence, static_cast<quint8>(key.query), key.from, key.to, key.timeZone);
+}
+
+// Hashes everything the occurrences of @p incidence depend on: its dates and
+// every field of its recurrence rules and dates. Reading them does not allocate,
+// so rehashing on every hit stays far cheaper than expanding the recurrence
+size_t occurrenceHash(const Incidence::Ptr &incidence)
+{
+    const Recurrence *recurrence = incidence->recurrence();
+    const QDateTime start = incidence->dtStart();
+    size_t seed = qHashMulti(0, start, start.timeZone().id(), incidence->dateTime(Incidence::RoleEnd), incidence->allDay());
+    seed = qHashMulti(seed, recurrence->rDateTimes(), recurrence->rDates(), recurrence->exDateTimes(), recurrence->exDates());
+
+    const auto hashRules = [&seed](const RecurrenceRule::List &rules) {
+        seed = qHash(rules.size(), seed);
+        for (const RecurrenceRule *rule : rules) {
+            seed = qHashMulti(seed,
+                              static_cast<int>(rule->recurrenceType()),
+                              rule->frequency(),
+                              rule->duration(),
+                              rule->startDt(),
+                              rule->endDt(),
+                              rule->allDay(),
+                              rule->weekStart());
+            seed = qHashMulti(seed,
+                              rule->bySeconds(),
+                              rule->byMinutes(),
+                              rule->byHours(),
+                              rule->byMonthDays(),
+                              rule->byYearDays(),
+                              rule->byWeekNumbers(),
+                              rule->byMonths(),
+                              rule->bySetPos());
+            const QList<RecurrenceRule::WDayPos> days = rule->byDays();
+            seed = qHash(days.size(), seed);
+            for (const RecurrenceRule::WDayPos &day : days) {
+                seed = qHashMulti(seed, day.day(), day.pos());
+            }
+        }
+    };
+    hashRules(recurrence->rRules());
+    hashRules(recurrence->exRules());
+    return seed;
+}
+
+struct Entry {
+    // Detects incidences deleted since, whose address may have been reused
+    QWeakPointer<Incidence> incidence;
+    size_t hash = 0;
+    QList<QDateTime> result;
+};
+
+struct Cache {
+    QMutex mutex;
+    // Costs are counted in date-times, each entry counting as one more
+    QCache<Key, Entry> entries{1 << 16};
+};
+}
+
+Q_GLOBAL_STATIC(Cache, sCache)
+
+static std::optional<QList<QDateTime>> lookup(const Key &key, const Incidence::Ptr &incidence)
+{
+    Cache *const cache = sCache();
+    const QMutexLocker locker(&cache->mutex);
+    const Entry *entry = cache->entries.object(key);
+    if (!entry) {
+        return std::nullopt;
+    }
+    if (entry->incidence.toStrongRef() != incidence || entry->hash != occurrenceHash(incidence)) {
+        cache->entries.remove(key);
+        return std::nullopt;
+    }
+    return entry->result;
+}
+
+static void store(const Key &key, const Incidence::Ptr &incidence, const QList<QDateTime> &result)
+{
+    auto entry = new Entry{incidence.toWeakRef(), occurrenceHash(incidence), result};
+    Cache *const cache = sCache();
+    const QMutexLocker locker(&cache->mutex);
+    cache->entries.insert(key, entry, 1 + result.size());
+}
+
+template<typename Compute>
+static QList<QDateTime> cached(const Incidence::Ptr &incidence, Key key, Compute compute)
+{
+    key.incidence = incidence.data();
+    if (auto result = lookup(key, incidence)) {
+        return *result;
+    }
+    // Computed without holding the lock, other threads keep being served meanwhile
+    const QList<QDateTime> result = compute();
+    store(key, incidence, result);
+    return result;
+}
+
+QList<QDateTime> OccurrenceCache::timesInInterval(const Incidence::Ptr &incidence, const QDateTime &start, const QDateTime &end)
+{
+    if (!incidence->recurs()) {
+        return incidence->recurrence()->timesInInterval(start, end);
+    }
+    return cached(incidence, Key{nullptr, Query::TimesInInterval, start.toMSecsSinceEpoch(), end.toMSecsSinceEpoch(), {}}, [&]() {
+        return incidence->recurrence()->timesInInterval(start, end);
+    });
+}
+
+QDateTime OccurrenceCache::previousDateTime(const Incidence::Ptr &incidence, const QDateTime &dateTime)
+{
+    if (!incidence->recurs()) {
+        return incidence->recurrence()->getPreviousDateTime(dateTime);
+    }
+    const QList<QDateTime> result = cached(incidence, Key{nullptr, Query::PreviousDateTime, dateTime.toMSecsSinceEpoch(), 0, {}}, [&]() {
+        return QList<QDateTime>{incidence->recurrence()->getPreviousDateTime(dateTime)};
+    });
+    return result.value(0);
+}
+
+QDateTime OccurrenceCache::nextDateTime(const Incidence::Ptr &incidence, const QDateTime &dateTime)
+{
+    if (!incidence->recurs()) {
+        return incidence->recurrence()->getNextDateTime(dateTime);
+    }
+    const QList<QDateTime> result = cached(incidence, Key{nullptr, Query::NextDateTime, dateTime.toMSecsSinceEpoch(), 0, {}}, [&]() {
+        return QList<QDateTime>{incidence->recurrence()->getNextDateTime(dateTime)};
+    });
+    return result.value(0);
+}
+
+QList<QDateTime> OccurrenceCache::startDateTimesForDate(const Incidence::Ptr &incidence, QDate date, const QTimeZone &timeZone)
+{
+    if (!incidence->recurs()) {
+        return incidence->startDateTimesForDate(date, timeZone);
+    }
+    return cached(incidence, Key{nullptr, Query::StartDateTimesForDate, date.toJulianDay(), 0, timeZone.id()}, [&]() {
+        return incidence->startDateTimesForDate(date, timeZone);
+    });
+}
+
+void OccurrenceCache::clear()
+{
+    Cache *const cache = sCache();
+    const QMutexLocker locker(&cache->mutex);
+    cache->entries.clear();
+}
+
+qsizetype OccurrenceCache::size()
+{
+    Cache *const cache = sCache();
+    const QMutexLocker locker(&cache->mutex);
+    return cache->entries.size();
+}
@@ -0,0 +1,52 @@
+/*
+  This file is part of the kcalutils library.
+
+  SPDX-FileCopyrightText: 2026 KDE PIM developers
+
+  SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kcalutils_private_export.h"
+
+#include <KCalendarCore/Incidence>
+
+#include <QDateTime>
+#include <QList>
+#include <QTimeZone>
+
+namespace KCalUtils
+{
+/*
+ * Memoizes the recurrence expansions the formatters and RecurrenceActions
+ * need, so that a view showing the same series several times computes its
+ * occurrences once.
+ *
+ * Results are keyed by incidence and queried window and kept in a cache
+ * bounded by the number of date-times it holds and safe to use from several
+ * threads. Each result remembers a hash of the dates of the incidence and of
+ * all fields of its recurrence rules and dates, and is dropped once the
+ * incidence is gone or the hash changed, so edits never return stale
+ * occurrences, whether or not the incidence belongs to a calendar.
+ */
+namespace OccurrenceCache
+{
+/* Same as incidence->recurrence()->timesInInterval(start, end) */
+[[nodiscard]] KCALUTILS_TESTS_EXPORT QList<QDateTime>
+timesInInterval(const KCalendarCore::Incidence::Ptr &incidence, const QDateTime &start, const QDateTime &end);
+
+/* Same as incidence->recurrence()->getPreviousDateTime(dateTime) */
+[[nodiscard]] KCALUTILS_TESTS_EXPORT QDateTime previousDateTime(const KCalendarCore::Incidence::Ptr &incidence, const QDateTime &dateTime);
+
+/* Same as incidence->recurrence()->getNextDateTime(dateTime) */
+[[nodiscard]] KCALUTILS_TESTS_EXPORT QDateTime nextDateTime(const KCalendarCore::Incidence::Ptr &incidence, const QDateTime &dateTime);
+
+/* Same as incidence->startDateTimesForDate(date, timeZone) */
+[[nodiscard]] KCALUTILS_TESTS_EXPORT QList<QDateTime>
+startDateTimesForDate(const KCalendarCore::Incidence::Ptr &incidence, QDate date, const QTimeZone &timeZone);
+
+KCALUTILS_EXPORT void clear();
+[[nodiscard]] KCALUTILS_TESTS_EXPORT qsizetype size();
+}
+}
@@ -10,6 +10,7 @@
 */
 
 #include "recurrenceactions.h"
+#include "occurrencecache_p.h"
 
 #include <KGuiItem>
 #include <KLocalizedString>
@@ -32,11 +33,11 @@ int RecurrenceActions::availableOccurrences(const Incidence::Ptr &incidence, con
         result |= SelectedOccurrence;
     }
 
-    if (incidence->recurrence()->getPreviousDateTime(selectedOccurrence).isValid()) {
+    if (OccurrenceCache::previousDateTime(incidence, selectedOccurrence).isValid()) {
         result |= PastOccurrences;
     }
 
-    if (incidence->recurrence()->getNextDateTime(selectedOccurrence).isValid()) {
+    if (OccurrenceCache::nextDateTime(incidence, selectedOccurrence).isValid()) {
         result |= FutureOccurrences;
     }
 
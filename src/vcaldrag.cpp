@@ -40,10 +40,9 @@ bool VCalDrag::fromMimeData(const QMimeData *de, const Calendar::Ptr &cal)
     bool success = false;
     const QByteArray payload = de->data(mimeType());
     if (!payload.isEmpty()) {
-        const QString txt = QString::fromUtf8(payload.data());
-
+        // Hand the payload to the parser as is, without a round trip through QString
         VCalFormat format;
-        success = format.fromString(cal, txt);
+        success = format.fromRawString(cal, payload);
     }
 
     return success;